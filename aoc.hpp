@@ -2,21 +2,50 @@
 #ifndef AOC_HPP_INCLUDED
 #define AOC_HPP_INCLUDED
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <optional>
+#include <print>
+#include <random>
+#include <ranges>
 #include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#if __has_include(<sys/mman.h>)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define AOC_HAVE_MMAP 1
+#endif
+
+#if __has_include(<experimental/simd>)
+#    include <experimental/simd>
+#    define AOC_HAVE_STD_SIMD 1
+#endif
+
+#if defined(__SSE2__)
+#    include <immintrin.h>
+#endif
+
 #include <ankerl/unordered_dense.h>
 
 #include <flux.hpp>
@@ -29,6 +58,153 @@ using hash_map = ankerl::unordered_dense::map<K, V>;
 template <typename K>
 using hash_set = ankerl::unordered_dense::set<K>;
 
+// Stores copies of strings in large blocks, so that interning many small
+// strings does not need an allocation for each one. The returned views remain
+// valid for the lifetime of the arena.
+struct string_arena {
+    static constexpr std::size_t block_size = 64 * 1024;
+
+    auto store(std::string_view str) -> std::string_view
+    {
+        // Needs no storage, and there may not be a block to point into yet
+        if (str.empty()) {
+            return {};
+        }
+
+        if (str.size() > capacity_ - used_) {
+            capacity_ = std::max(block_size, str.size());
+            blocks_.push_back(std::make_unique_for_overwrite<char[]>(capacity_));
+            used_ = 0;
+        }
+        char* dest = blocks_.back().get() + used_;
+        std::ranges::copy(str, dest);
+        used_ += str.size();
+        return {dest, str.size()};
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t used_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+// Memoisation table for recursive solutions
+//
+// Each distinct key is interned the first time it is seen, and given a small
+// integer id. String keys are copied into an arena, so callers can look up
+// temporary views without allocating. Values are kept in a flat vector indexed
+// by id, so once a caller has an id, no further hashing is needed.
+//
+// If Capacity is non-zero then at most Capacity values are kept at once, and
+// older values are evicted using the CLOCK approximation of LRU. Interned keys
+// (and their ids) are never evicted.
+//
+// Ids have their own type, so that when keys are integers a key can't be
+// passed where an id is expected, or the other way round.
+enum class memo_id : std::uint32_t {};
+
+template <typename Key, typename Value, std::size_t Capacity = 0>
+struct memo {
+    static constexpr bool is_string_key
+        = std::is_convertible_v<Key const&, std::string_view>;
+
+    using key_type = std::conditional_t<is_string_key, std::string_view, Key>;
+    using id_type = memo_id;
+
+    // Returns the id of key, interning it if it has not been seen before
+    auto intern(key_type const& key) -> id_type
+    {
+        if (auto iter = ids_.find(key); iter != ids_.end()) {
+            return iter->second;
+        }
+
+        auto const id = id_type(keys_.size());
+        if constexpr (is_string_key) {
+            keys_.push_back(arena_.store(key));
+        } else {
+            keys_.push_back(key);
+        }
+        ids_.emplace(keys_.back(), id);
+        values_.emplace_back();
+        if constexpr (Capacity > 0) {
+            referenced_.push_back(false);
+        }
+        return id;
+    }
+
+    auto key(id_type id) const -> key_type const&
+    {
+        return keys_.at(std::to_underlying(id));
+    }
+
+    // Returns the number of interned keys: all ids are less than this
+    auto size() const -> std::size_t { return keys_.size(); }
+
+    // Returns a pointer to the value stored for id, or nullptr if there is none
+    auto find(id_type id) -> Value const*
+    {
+        auto& value = values_.at(std::to_underlying(id));
+        if constexpr (Capacity > 0) {
+            referenced_[std::to_underlying(id)] = value.has_value();
+        }
+        return value ? &*value : nullptr;
+    }
+
+    // Equivalent to find(intern(key))
+    auto find(key_type const& key) -> Value const* { return find(intern(key)); }
+
+    // Stores value for id, returning a reference to the stored value. The
+    // reference is invalidated by the next call to intern() or insert().
+    auto insert(id_type id, Value value) -> Value const&
+    {
+        if constexpr (Capacity > 0) {
+            if (!values_.at(std::to_underlying(id))) {
+                make_room(id);
+            }
+        }
+        return values_.at(std::to_underlying(id)).emplace(std::move(value));
+    }
+
+    // Equivalent to insert(intern(key), value)
+    auto insert(key_type const& key, Value value) -> Value const&
+    {
+        return insert(intern(key), std::move(value));
+    }
+
+private:
+    // Ensures that there is space to store one more value, evicting one if
+    // necessary, and records that id is now resident
+    void make_room(id_type id)
+    {
+        if (resident_.size() < Capacity) {
+            resident_.push_back(id);
+            return;
+        }
+
+        // Give each recently used value a second chance before evicting it
+        while (referenced_[std::to_underlying(resident_[hand_])]) {
+            referenced_[std::to_underlying(resident_[hand_])] = false;
+            hand_ = (hand_ + 1) % Capacity;
+        }
+        values_[std::to_underlying(resident_[hand_])].reset();
+        resident_[hand_] = id;
+        hand_ = (hand_ + 1) % Capacity;
+    }
+
+    struct empty {};
+
+    [[no_unique_address]] std::conditional_t<is_string_key, string_arena, empty>
+        arena_;
+    std::vector<key_type> keys_;
+    hash_map<key_type, id_type> ids_;
+    std::vector<std::optional<Value>> values_;
+
+    // Bookkeeping for bounded tables
+    std::vector<bool> referenced_;
+    std::vector<id_type> resident_;
+    std::size_t hand_ = 0;
+};
+
 // This function is not great, but nor are the alternatives:
 //  * std::from_chars - not constexpr, requires contiguous input
 //  * std::atoi - same
@@ -100,6 +276,426 @@ constexpr auto string_from_file = [](const char* path) {
     return flux::from_istreambuf(file).template to<std::string>();
 };
 
+// A read-only view of the contents of a file. Where the platform allows it the
+// file is memory-mapped, otherwise it is simply read into memory.
+struct mapped_file {
+    static auto open(char const* path) -> std::optional<mapped_file>
+    {
+#ifdef AOC_HAVE_MMAP
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return std::nullopt;
+        }
+        mapped_file file;
+        // An empty file can't be mapped, but is still a valid (empty) view,
+        // as it is when the file is read instead
+        if (st.st_size > 0) {
+            void* addr
+                = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                return std::nullopt;
+            }
+            file.bytes_ = {static_cast<std::byte const*>(addr),
+                           std::size_t(st.st_size)};
+        }
+        ::close(fd);
+        return file;
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            return std::nullopt;
+        }
+        std::size_t const size = in.tellg();
+        mapped_file file;
+        // Use 8-byte units so that the contents are suitably aligned
+        file.storage_.resize((size + 7) / 8);
+        in.seekg(0).read(reinterpret_cast<char*>(file.storage_.data()), size);
+        file.bytes_ = std::as_bytes(std::span(file.storage_)).first(size);
+        return file;
+#endif
+    }
+
+    mapped_file(mapped_file&& other) noexcept
+        : bytes_(std::exchange(other.bytes_, {}))
+#ifndef AOC_HAVE_MMAP
+          ,
+          storage_(std::move(other.storage_))
+#endif
+    {}
+
+    mapped_file& operator=(mapped_file&&) = delete;
+
+    ~mapped_file()
+    {
+#ifdef AOC_HAVE_MMAP
+        if (!bytes_.empty()) {
+            ::munmap(const_cast<std::byte*>(bytes_.data()), bytes_.size());
+        }
+#endif
+    }
+
+    auto bytes() const -> std::span<std::byte const> { return bytes_; }
+
+private:
+    mapped_file() = default;
+
+    std::span<std::byte const> bytes_;
+#ifndef AOC_HAVE_MMAP
+    std::vector<std::uint64_t> storage_;
+#endif
+};
+
+// Pre-parsed input caches
+//
+// A day can save its parsed input to a flat binary file alongside the input
+// ("<input>.cache"), and on later runs map that file rather than parsing the
+// text again. The file is a header, a table of sections, and the sections
+// themselves. Each section is an array of trivially copyable values, located
+// by its offset from the start of the file, so the mapped file can be read in
+// place. The header records a checksum of the input text and a version number
+// which the day bumps whenever its layout changes, so a stale cache is ignored.
+namespace cache {
+
+inline constexpr std::uint32_t magic = 0x43434f41; // "AOCC"
+inline constexpr std::uint32_t format_version = 1;
+inline constexpr std::size_t alignment = 16;
+
+struct header {
+    std::uint32_t magic;
+    std::uint32_t format_version;
+    std::uint32_t day_version;
+    std::uint32_t n_sections;
+    std::uint64_t checksum;
+};
+
+struct section_info {
+    std::uint64_t offset;
+    std::uint64_t size; // in bytes
+};
+
+constexpr auto align_up = [](std::uint64_t n) -> std::uint64_t {
+    return (n + alignment - 1) / alignment * alignment;
+};
+
+// Returns whether offsets can safely be used to slice an array of size
+// elements: they must start at zero, never decrease, and end at size. The
+// checksum only covers the input text, so a cache's contents must be checked
+// before they are trusted.
+constexpr auto offsets_valid
+    = [](auto const& offsets, std::size_t size) -> bool {
+    return !offsets.empty() && offsets.front() == 0 && offsets.back() == size
+        && std::ranges::is_sorted(offsets);
+};
+
+struct writer {
+    // Appends a contiguous range of trivially copyable values as a new section
+    template <std::ranges::contiguous_range R>
+        requires std::is_trivially_copyable_v<std::ranges::range_value_t<R>>
+    void add(R const& values)
+    {
+        auto const bytes = std::as_bytes(std::span(values));
+        sections_.emplace_back(bytes.begin(), bytes.end());
+    }
+
+    // Appends two sections: the characters of all of the strings, followed by
+    // the offset of the start of each string (plus a final end offset)
+    void add_strings(auto const& strings)
+    {
+        std::string chars;
+        std::vector<std::uint64_t> offsets{0};
+        for (std::string_view str : strings) {
+            chars += str;
+            offsets.push_back(chars.size());
+        }
+        add(chars);
+        add(offsets);
+    }
+
+    // Writes the cache to a temporary file which then replaces path, so that
+    // another process reading the cache never sees it half written
+    auto save(std::string const& path, std::uint32_t version,
+              std::uint64_t checksum) const -> bool
+    {
+        std::string const tmp_path
+            = std::format("{}.{:x}.tmp", path, std::random_device{}());
+        std::error_code ec;
+        if (!write(tmp_path, version, checksum)) {
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+
+        std::filesystem::rename(tmp_path, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::vector<std::vector<std::byte>> sections_;
+
+    auto write(std::string const& path, std::uint32_t version,
+               std::uint64_t checksum) const -> bool
+    {
+        std::ofstream out(path, std::ios::binary);
+
+        header const hdr{.magic = magic,
+                         .format_version = format_version,
+                         .day_version = version,
+                         .n_sections = std::uint32_t(sections_.size()),
+                         .checksum = checksum};
+        out.write(reinterpret_cast<char const*>(&hdr), sizeof(hdr));
+
+        std::uint64_t offset = align_up(
+            sizeof(header) + sections_.size() * sizeof(section_info));
+        for (auto const& section : sections_) {
+            section_info const info{offset, section.size()};
+            out.write(reinterpret_cast<char const*>(&info), sizeof(info));
+            offset = align_up(offset + section.size());
+        }
+
+        for (auto const& section : sections_) {
+            std::array<char, alignment> const padding{};
+            out.write(padding.data(),
+                      align_up(out.tellp()) - std::uint64_t(out.tellp()));
+            out.write(reinterpret_cast<char const*>(section.data()),
+                      section.size());
+        }
+
+        out.close();
+        return bool(out);
+    }
+};
+
+struct reader {
+    // Maps the cache file at path, returning nullopt if it does not exist or
+    // if it does not match the given version and input checksum
+    static auto open(char const* path, std::uint32_t version,
+                     std::uint64_t checksum) -> std::optional<reader>
+    {
+        auto file = mapped_file::open(path);
+        if (!file || file->bytes().size() < sizeof(header)) {
+            return std::nullopt;
+        }
+
+        auto const bytes = file->bytes();
+        header hdr;
+        std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+        if (hdr.magic != magic || hdr.format_version != format_version
+            || hdr.day_version != version || hdr.checksum != checksum
+            || bytes.size()
+                < sizeof(header) + hdr.n_sections * sizeof(section_info)) {
+            return std::nullopt;
+        }
+
+        std::span const sections{
+            reinterpret_cast<section_info const*>(bytes.data() + sizeof(hdr)),
+            hdr.n_sections};
+        for (auto const& [offset, size] : sections) {
+            // Written this way round so that it can't overflow
+            if (offset % alignment != 0 || size > bytes.size()
+                || offset > bytes.size() - size) {
+                return std::nullopt;
+            }
+        }
+
+        return reader(std::move(*file), sections);
+    }
+
+    // Returns a view of section idx as an array of T, or nullopt if there is
+    // no such section or its size is not a whole number of Ts
+    template <typename T>
+    auto section(std::size_t idx) const -> std::optional<std::span<T const>>
+    {
+        if (idx >= sections_.size() || sections_[idx].size % sizeof(T) != 0) {
+            return std::nullopt;
+        }
+        auto const& [offset, size] = sections_[idx];
+        return std::span<T const>(
+            reinterpret_cast<T const*>(file_.bytes().data() + offset),
+            size / sizeof(T));
+    }
+
+    // Returns views of the strings saved by writer::add_strings(), starting
+    // at section idx, or nullopt if the sections are malformed
+    auto strings(std::size_t idx) const
+        -> std::optional<std::vector<std::string_view>>
+    {
+        auto const chars = section<char>(idx);
+        auto const offsets = section<std::uint64_t>(idx + 1);
+        if (!chars || !offsets || !offsets_valid(*offsets, chars->size())) {
+            return std::nullopt;
+        }
+        return flux::ref(*offsets)
+            .pairwise_map([&](std::uint64_t from, std::uint64_t to) {
+                return std::string_view(chars->data() + from, to - from);
+            })
+            .to<std::vector>();
+    }
+
+private:
+    reader(mapped_file file, std::span<section_info const> sections)
+        : file_(std::move(file)), sections_(sections)
+    {}
+
+    mapped_file file_;
+    std::span<section_info const> sections_;
+};
+
+} // namespace cache
+
+// Returns the parsed form of the input file at path. If an up-to-date cache of
+// the input exists then it is mapped and passed to load(), otherwise the text
+// is passed to parse() and the result is written to a new cache using save().
+// load() returns an optional, and nullopt means the cache is malformed, in
+// which case we parse the text as if there were no cache.
+constexpr auto parse_cached = [](char const* path, std::uint32_t version,
+                                 auto const& parse, auto const& save,
+                                 auto const& load) {
+    std::string const text = string_from_file(path);
+    std::uint64_t const checksum
+        = ankerl::unordered_dense::detail::wyhash::hash(text.data(),
+                                                        text.size());
+    std::string const cache_path = std::string(path) + ".cache";
+
+    if (auto reader
+        = cache::reader::open(cache_path.c_str(), version, checksum)) {
+        if (auto loaded = load(*reader)) {
+            return std::move(*loaded);
+        }
+    }
+
+    auto parsed = parse(text);
+    cache::writer writer;
+    save(parsed, writer);
+    if (!writer.save(cache_path, version, checksum)) {
+        std::println(stderr, "Warning: could not write {}", cache_path);
+    }
+    return parsed;
+};
+
+// Returns the argument following the command-line option name (for example
+// "--size 71"), or nullopt if the option was not given
+constexpr auto get_option = [](int argc, char** argv, std::string_view name)
+    -> std::optional<std::string_view> {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (argv[i] == name) {
+            return argv[i + 1];
+        }
+    }
+    return std::nullopt;
+};
+
+// Returns whether the command-line flag name (for example "--bench") was given
+constexpr auto has_flag
+    = [](int argc, char** argv, std::string_view name) -> bool {
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == name) {
+            return true;
+        }
+    }
+    return false;
+};
+
+// Calls func with std::integral_constant<T, V> if value is equal to one of the
+// given Values, so that func can be compiled with the value as a constant, or
+// otherwise with the run-time value itself as a fallback
+template <auto... Values>
+constexpr auto dispatch = [](auto const& value, auto const& func) {
+    using T = std::remove_cvref_t<decltype(value)>;
+    using result_t = std::invoke_result_t<decltype(func), T const&>;
+
+    std::optional<result_t> result;
+    (void) ((value == Values
+             && (result.emplace(func(std::integral_constant<T, Values>{})),
+                 true))
+            || ...);
+    return result ? *std::move(result) : func(value);
+};
+
+// The value carried by T if it is a std::integral_constant (as passed by
+// dispatch() above), or Default if it is not
+template <typename T, auto Default>
+inline constexpr auto constant_or = Default;
+
+template <typename T, T Value, auto Default>
+inline constexpr auto constant_or<std::integral_constant<T, Value>, Default>
+    = Value;
+
+// Number of worker threads to use for the parallel helpers below
+inline auto thread_count() -> std::size_t
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// Splits input into at most n_chunks pieces of roughly equal size. Each piece
+// ends just after a newline, so no line is ever divided between two chunks.
+constexpr auto split_lines
+    = [](std::string_view input,
+         std::size_t n_chunks) -> std::vector<std::string_view> {
+    std::size_t const chunk_size
+        = input.size() / std::max(n_chunks, std::size_t{1}) + 1;
+
+    std::vector<std::string_view> chunks;
+    while (!input.empty()) {
+        auto end = input.find('\n', std::min(chunk_size, input.size()) - 1);
+        end = (end == std::string_view::npos) ? input.size() : end + 1;
+        chunks.push_back(input.substr(0, end));
+        input.remove_prefix(end);
+    }
+    return chunks;
+};
+
+// Splits items into n_chunks contiguous pieces whose sizes differ by at most
+// one
+constexpr auto split_span = []<typename T>(std::span<T> items,
+                                           std::size_t n_chunks)
+    -> std::vector<std::span<T>> {
+    std::vector<std::span<T>> chunks;
+    for (std::size_t i = 0; i < n_chunks; ++i) {
+        std::size_t const from = items.size() * i / n_chunks;
+        std::size_t const to = items.size() * (i + 1) / n_chunks;
+        chunks.push_back(items.subspan(from, to - from));
+    }
+    return chunks;
+};
+
+// Calls func on each element of items on a separate thread, and returns the
+// results in the same order as the input
+constexpr auto parallel_map = [](auto const& items, auto const& func) {
+    using result_t
+        = std::invoke_result_t<decltype(func), decltype(*std::begin(items))>;
+
+    std::vector<std::future<result_t>> futures;
+    for (auto const& item : items) {
+        futures.push_back(std::async(std::launch::async,
+                                     [&func, &item] { return func(item); }));
+    }
+
+    std::vector<result_t> results;
+    results.reserve(futures.size());
+    for (auto& fut : futures) {
+        results.push_back(fut.get());
+    }
+    return results;
+};
+
+// Divides input into one block of lines per thread and runs func (typically
+// parse-then-solve) on each block concurrently, so that parsing and solving
+// overlap. The per-block results are then combined in order using op.
+constexpr auto parallel_fold_lines
+    = [](std::string_view input, auto const& func, auto init, auto op) {
+    auto results = parallel_map(split_lines(input, thread_count()), func);
+    return flux::fold(results, std::move(op), std::move(init));
+};
+
 struct timer {
     using clock = std::chrono::high_resolution_clock;
 
@@ -123,6 +719,208 @@ constexpr auto timed(F&& f, Args&&... args)
     return {std::invoke(FLUX_FWD(f), FLUX_FWD(args)...), t.elapsed<D>()};
 }
 
+// A named implementation of an algorithm. Days which have several ways of
+// solving a part keep them in an array of strategies with the same signature,
+// so that one can be chosen at run time or all of them compared.
+template <typename R, typename... Args>
+struct strategy {
+    std::string_view name;
+    R (*func)(Args...);
+};
+
+// Returns the strategy with the given name, or nullopt if there is none
+constexpr auto find_strategy
+    = [](auto const& strategies, std::string_view name) {
+    using strategy_t = std::ranges::range_value_t<decltype(strategies)>;
+    auto iter = std::ranges::find(strategies, name, &strategy_t::name);
+    return iter == std::ranges::end(strategies)
+        ? std::optional<strategy_t>{}
+        : std::optional<strategy_t>{*iter};
+};
+
+// Formats the result of a strategy, which may be an optional
+constexpr auto format_result = [](auto const& result) -> std::string {
+    if constexpr (requires { result.has_value(); }) {
+        return result ? std::format("{}", *result) : std::string("none");
+    } else {
+        return std::format("{}", result);
+    }
+};
+
+// Runs every strategy with the same arguments and prints a table of their
+// results and timings, relative to the first strategy in the list. Returns
+// false if the strategies did not all produce the same result.
+constexpr auto compare_strategies = [](std::string_view title,
+                                       auto const& strategies,
+                                       auto const&... args) -> bool {
+    std::println("{}", title);
+    std::println("  {:<16} {:>24} {:>12} {:>8}", "strategy", "result", "time",
+                 "ratio");
+
+    std::string expected;
+    double baseline = 0.0;
+    bool all_match = true;
+
+    for (auto const& [name, func] : strategies) {
+        auto const [result, time] = timed(func, args...);
+        auto const result_str = format_result(result);
+
+        if (expected.empty()) {
+            expected = result_str;
+            baseline = std::max(double(time.count()), 1.0);
+        }
+
+        bool const match = result_str == expected;
+        all_match &= match;
+
+        std::println("  {:<16} {:>24} {:>12} {:>7.2f}x{}", name, result_str,
+                     std::format("{}", time), time.count() / baseline,
+                     match ? "" : "  MISMATCH");
+    }
+
+    return all_match;
+};
+
+// Portable SIMD helpers
+//
+// These are built on std::experimental::simd where the standard library
+// provides it, plus x86 intrinsics for byte matching, selected at compile time
+// by the target flags (-msse2, -mavx2 etc). Every function also has a plain
+// scalar implementation, which is used during constant evaluation (so that the
+// static_assert tests keep working) and on platforms with no SIMD support.
+namespace simd {
+
+#ifdef AOC_HAVE_STD_SIMD
+namespace stdx = std::experimental;
+
+template <typename T>
+using native = stdx::native_simd<T>;
+
+// A batch holding 0, 1, 2, ... in successive lanes
+template <typename T>
+inline native<T> const lane_indices([](auto i) { return T(i); });
+
+// Loads the first min(src.size(), native<T>::size()) elements of src, and
+// sets any remaining lanes to fill. Never reads past the end of src.
+template <typename T>
+auto load_partial(std::span<T const> src, T fill = T{}) -> native<T>
+{
+    native<T> batch;
+    if (src.size() >= batch.size()) {
+        batch.copy_from(src.data(), stdx::element_aligned);
+    } else {
+        std::array<T, native<T>::size()> buf;
+        buf.fill(fill);
+        std::ranges::copy(src, buf.begin());
+        batch.copy_from(buf.data(), stdx::element_aligned);
+    }
+    return batch;
+}
+
+// Horizontal sum of the lanes of a batch
+template <typename T>
+auto reduce_sum(native<T> const& batch) -> T
+{
+    return stdx::reduce(batch);
+}
+#endif
+
+// Lane-wise absolute value, for both scalars and SIMD batches
+constexpr auto abs = [](auto const& x) {
+    if constexpr (std::is_arithmetic_v<std::remove_cvref_t<decltype(x)>>) {
+        return x < 0 ? -x : x;
+    } else {
+#ifdef AOC_HAVE_STD_SIMD
+        auto result = x;
+        stdx::where(x < 0, result) = -x;
+        return result;
+#endif
+    }
+};
+
+// Returns the sum of f(a[i], b[i]) over the common length of a and b, which
+// must be contiguous ranges of the same arithmetic type. f is called with
+// whole SIMD batches where possible, so must work with batches and scalars.
+constexpr auto transform_sum = [](auto const& a, auto const& b, auto const& f) {
+    using T = std::ranges::range_value_t<decltype(a)>;
+    std::span<T const> const lhs(a);
+    std::span<T const> const rhs(b);
+    std::size_t const n = std::min(lhs.size(), rhs.size());
+
+    auto scalar_sum = [&](std::size_t from) {
+        T sum{};
+        for (std::size_t i = from; i < n; ++i) {
+            sum += f(lhs[i], rhs[i]);
+        }
+        return sum;
+    };
+
+    if consteval {
+        return scalar_sum(0);
+    } else {
+#ifdef AOC_HAVE_STD_SIMD
+        using V = native<T>;
+        V acc = 0;
+        std::size_t i = 0;
+        for (; i + V::size() <= n; i += V::size()) {
+            acc += f(V(lhs.data() + i, stdx::element_aligned),
+                     V(rhs.data() + i, stdx::element_aligned));
+        }
+        if (i < n) {
+            // Masked tail: discard the lanes past the end of the input
+            V tail = f(load_partial(lhs.subspan(i, n - i)),
+                       load_partial(rhs.subspan(i, n - i)));
+            stdx::where(lane_indices<T> >= T(n - i), tail) = 0;
+            acc += tail;
+        }
+        return reduce_sum(acc);
+#else
+        return scalar_sum(0);
+#endif
+    }
+};
+
+// Returns a bitmask in which bit i is set if bytes[i] == c. At most 64 bytes
+// may be tested at a time.
+constexpr auto match_mask
+    = [](std::string_view bytes, char c) -> std::uint64_t {
+    assert(bytes.size() <= 64);
+
+    if !consteval {
+#if defined(__AVX2__)
+        if (bytes.size() == 64) {
+            auto const* ptr = reinterpret_cast<__m256i const*>(bytes.data());
+            auto const needle = _mm256_set1_epi8(c);
+            std::uint32_t const lo = _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256(ptr), needle));
+            std::uint32_t const hi = _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256(ptr + 1), needle));
+            return lo | (std::uint64_t(hi) << 32);
+        }
+#elif defined(__SSE2__)
+        if (bytes.size() == 64) {
+            auto const* ptr = reinterpret_cast<__m128i const*>(bytes.data());
+            auto const needle = _mm_set1_epi8(c);
+            std::uint64_t mask = 0;
+            for (int i = 0; i < 4; ++i) {
+                std::uint32_t const m = _mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_loadu_si128(ptr + i), needle));
+                mask |= std::uint64_t(m) << (16 * i);
+            }
+            return mask;
+        }
+#endif
+    }
+
+    std::uint64_t mask = 0;
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        mask |= std::uint64_t(bytes[i] == c) << i;
+    }
+    return mask;
+};
+
+} // namespace simd
+
 template <typename T>
 struct vec2_t {
     T x = T{};
@@ -163,6 +961,111 @@ struct vec2_t {
     }
 };
 
+// Storage layouts for 2D grids. Each layout maps a position to an offset into
+// the grid's storage, and says how many cells of storage a grid of the given
+// dimensions requires (which may be more than width * height).
+namespace layout {
+
+struct row_major {
+    static constexpr auto size(int width, int height) -> std::size_t
+    {
+        return std::size_t(width) * height;
+    }
+
+    static constexpr auto index(vec2_t<int> const& p, int width, int /*height*/)
+        -> std::size_t
+    {
+        return std::size_t(p.y) * width + p.x;
+    }
+};
+
+// Stores the grid as a row-major sequence of TileSize x TileSize tiles, each of
+// which is itself row-major, so that vertical neighbours are usually close
+template <int TileSize = 8>
+struct tiled {
+    static constexpr auto n_tiles(int n) -> std::size_t
+    {
+        return (n + TileSize - 1) / TileSize;
+    }
+
+    static constexpr auto size(int width, int height) -> std::size_t
+    {
+        return n_tiles(width) * n_tiles(height) * TileSize * TileSize;
+    }
+
+    static constexpr auto index(vec2_t<int> const& p, int width, int /*height*/)
+        -> std::size_t
+    {
+        auto tile = (p.y / TileSize) * n_tiles(width) + p.x / TileSize;
+        return tile * TileSize * TileSize + (p.y % TileSize) * TileSize
+            + p.x % TileSize;
+    }
+};
+
+// Z-order curve: the offset is formed by interleaving the bits of x and y
+struct morton {
+    // Inserts a zero bit between each of the bits of v
+    static constexpr auto spread_bits(std::uint32_t v) -> std::uint64_t
+    {
+        std::uint64_t x = v;
+        x = (x | (x << 16)) & 0x0000FFFF0000FFFF;
+        x = (x | (x << 8)) & 0x00FF00FF00FF00FF;
+        x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0F;
+        x = (x | (x << 2)) & 0x3333333333333333;
+        x = (x | (x << 1)) & 0x5555555555555555;
+        return x;
+    }
+
+    static constexpr auto size(int width, int height) -> std::size_t
+    {
+        auto side = std::bit_ceil(std::size_t(std::max(width, height)));
+        return side * side;
+    }
+
+    static constexpr auto index(vec2_t<int> const& p, int /*width*/,
+                                int /*height*/) -> std::size_t
+    {
+        return spread_bits(p.x) | (spread_bits(p.y) << 1);
+    }
+};
+
+} // namespace layout
+
+// A 2D grid of T, stored according to Layout
+template <typename T, typename Layout = layout::row_major>
+struct grid {
+    int width = 0;
+    int height = 0;
+    std::vector<T> data = std::vector<T>(Layout::size(width, height));
+
+    constexpr auto is_in_bounds(vec2_t<int> const& p) const -> bool
+    {
+        return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height;
+    }
+
+    constexpr auto operator[](this auto& self, vec2_t<int> const& p)
+        -> decltype(auto)
+    {
+        return self.data[Layout::index(p, self.width, self.height)];
+    }
+};
+
+// Parses lines of text, all of the same width, into a grid of characters. The
+// last line need not end with a newline.
+template <typename Layout = layout::row_major>
+constexpr auto parse_grid = [](std::string_view input) -> grid<char, Layout> {
+    auto const eol = input.find('\n');
+    int const width = int(eol == input.npos ? input.size() : eol);
+    grid<char, Layout> result{
+        .width = width, .height = int((input.size() + 1) / (width + 1))};
+    for (int y = 0; y < result.height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            result[{x, y}] = input[y * (width + 1) + x];
+        }
+    }
+    return result;
+};
+
 } // namespace aoc
 
 template <typename T>
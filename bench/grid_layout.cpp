@@ -0,0 +1,90 @@
+#include <aoc.hpp>
+
+// Compares the grid storage layouts in aoc.hpp by running a breadth-first
+// flood fill over a large grid with randomly placed walls. The walls and the
+// distance table are both stored using the layout being measured.
+
+namespace {
+
+using position = aoc::vec2_t<int>;
+
+constexpr std::array<position, 4> neighbour_offsets{
+    position{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
+
+template <typename Layout>
+auto const make_walls = [](int size) -> aoc::grid<char, Layout> {
+    aoc::grid<char, Layout> walls{.width = size, .height = size};
+
+    // Simple LCG so that every layout sees exactly the same grid
+    std::uint64_t state = 12345;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            state = state * 6364136223846793005 + 1442695040888963407;
+            walls[{x, y}] = (state >> 59) < 6 ? '#' : '.';
+        }
+    }
+    walls[{0, 0}] = '.';
+    return walls;
+};
+
+// dist must be filled with -1, and queue empty. They are passed in so that
+// allocating and clearing them, which depends on how much padding the layout
+// needs, is not part of the time measured.
+template <typename Layout>
+auto const flood_fill = [](aoc::grid<char, Layout> const& walls,
+                           aoc::grid<int, Layout>& dist,
+                           std::vector<position>& queue) -> std::int64_t {
+    queue.push_back({0, 0});
+    dist[{0, 0}] = 0;
+
+    std::int64_t total = 0;
+    for (std::size_t i = 0; i < queue.size(); ++i) {
+        position const pos = queue[i];
+        int const d = dist[pos];
+        total += d;
+
+        for (position offset : neighbour_offsets) {
+            position const next = pos + offset;
+            if (walls.is_in_bounds(next) && walls[next] != '#'
+                && dist[next] < 0) {
+                dist[next] = d + 1;
+                queue.push_back(next);
+            }
+        }
+    }
+    return total;
+};
+
+template <typename Layout>
+auto const run = [](std::string_view name, int size) -> std::int64_t {
+    auto const walls = make_walls<Layout>(size);
+    aoc::grid<int, Layout> dist{.width = size, .height = size};
+    flux::fill(dist.data, -1);
+    std::vector<position> queue;
+    queue.reserve(std::size_t(size) * size);
+
+    auto [total, time] = aoc::timed<std::chrono::milliseconds>(
+        flood_fill<Layout>, walls, dist, queue);
+    std::println("{:>12}: {} (checksum {})", name, time, total);
+    return total;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int const size = argc > 1 ? aoc::parse<int>(std::string_view(argv[1]))
+                              : 10'000;
+
+    std::println("Flood fill over {0}x{0} grid", size);
+
+    auto const expected = run<aoc::layout::row_major>("row-major", size);
+    bool ok = run<aoc::layout::tiled<8>>("tiled<8>", size) == expected;
+    ok &= run<aoc::layout::tiled<32>>("tiled<32>", size) == expected;
+    ok &= run<aoc::layout::morton>("morton", size) == expected;
+
+    if (!ok) {
+        std::println(stderr, "Layouts disagree!");
+        return 1;
+    }
+}
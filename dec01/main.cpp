@@ -1,13 +1,12 @@
 
 #include <aoc.hpp>
 
+#include <cmath>
+
 namespace {
 
 using i64 = std::int64_t;
 
-// std::abs is not constexpr
-const auto abs = [](i64 a) { return a < 0 ? -a : a; };
-
 const auto parse_input = [](std::string_view input)
     -> std::pair<std::vector<i64>, std::vector<i64>> {
     return flux::split_string(input, "\n")
@@ -26,18 +25,285 @@ const auto parse_input = [](std::string_view input)
             std::pair<std::vector<i64>, std::vector<i64>>{});
 };
 
+// LSD radix sort, one byte at a time. The histograms for every byte are built
+// in a single pass, and any pass in which all of the values have the same byte
+// (most of them, for location IDs) is skipped entirely.
+auto const radix_sort = [](std::vector<i64>& vec) {
+    // Flipping the sign bit makes negative values sort before positive ones
+    auto const digit = [](i64 val, int byte) -> std::size_t {
+        return ((std::uint64_t(val) ^ (std::uint64_t{1} << 63)) >> (8 * byte))
+            & 0xFF;
+    };
+
+    std::array<std::array<std::size_t, 256>, 8> counts{};
+    for (i64 val : vec) {
+        for (int byte = 0; byte < 8; ++byte) {
+            ++counts[byte][digit(val, byte)];
+        }
+    }
+
+    std::vector<i64> buffer(vec.size());
+    for (int byte = 0; byte < 8; ++byte) {
+        auto& offsets = counts[byte];
+        if (flux::contains(offsets, vec.size())) {
+            continue;
+        }
+
+        std::size_t total = 0;
+        for (auto& offset : offsets) {
+            total += std::exchange(offset, total);
+        }
+        for (i64 val : vec) {
+            buffer[offsets[digit(val, byte)]++] = val;
+        }
+        std::swap(vec, buffer);
+    }
+};
+
+// Sorts both columns, concurrently when not constant evaluating
+auto const sort_columns = [](std::vector<i64>& vec1, std::vector<i64>& vec2) {
+    if consteval {
+        radix_sort(vec1);
+        radix_sort(vec2);
+    } else {
+        auto fut = std::async(std::launch::async, [&] { radix_sort(vec1); });
+        radix_sort(vec2);
+        fut.get();
+    }
+};
+
+// Both vectors must be sorted
+auto const distance_sorted
+    = [](std::span<i64 const> sorted1, std::span<i64 const> sorted2) -> i64 {
+    return aoc::simd::transform_sum(sorted1, sorted2, [](auto a, auto b) {
+        return aoc::simd::abs(a - b);
+    });
+};
+
+// Both vectors must be sorted. Equal values form runs in each vector, so we
+// can sweep through them together like a merge, multiplying run lengths.
+auto const similarity_sorted
+    = [](std::span<i64 const> sorted1, std::span<i64 const> sorted2) -> i64 {
+    i64 total = 0;
+    std::size_t i = 0;
+    std::size_t j = 0;
+
+    while (i < sorted1.size() && j < sorted2.size()) {
+        if (sorted1[i] < sorted2[j]) {
+            ++i;
+        } else if (sorted2[j] < sorted1[i]) {
+            ++j;
+        } else {
+            i64 const val = sorted1[i];
+            i64 count1 = 0;
+            i64 count2 = 0;
+            for (; i < sorted1.size() && sorted1[i] == val; ++i) {
+                ++count1;
+            }
+            for (; j < sorted2.size() && sorted2[j] == val; ++j) {
+                ++count2;
+            }
+            total += val * count1 * count2;
+        }
+    }
+
+    return total;
+};
+
+// Takes its arguments by value: callers who no longer need the unsorted lists
+// should move them in to avoid copying
 auto part1 = [](std::vector<i64> vec1, std::vector<i64> vec2) -> i64 {
-    flux::sort(vec1);
-    flux::sort(vec2);
-    return flux::zip_fold(
-        [](i64 sum, i64 a, i64 b) { return sum + abs(a - b); }, 0, vec1, vec2);
+    sort_columns(vec1, vec2);
+    return distance_sorted(vec1, vec2);
 };
 
+// Value ranges up to this size are counted using a dense array rather than a
+// hash map
+constexpr i64 max_dense_range = 1 << 22;
+
 auto part2
     = [](std::vector<i64> const& vec1, std::vector<i64> const& vec2) -> i64 {
-    return flux::ref(vec1)
-        .map([&vec2](i64 elem) { return elem * flux::count_eq(vec2, elem); })
-        .sum();
+    if (vec2.empty()) {
+        return 0;
+    }
+
+    auto const [min, max] = std::ranges::minmax(vec2);
+
+    if (max - min < max_dense_range) {
+        std::vector<i64> counts(max - min + 1);
+        for (i64 val : vec2) {
+            ++counts[val - min];
+        }
+        return flux::ref(vec1)
+            .filter([&](i64 val) { return val >= min && val <= max; })
+            .map([&](i64 val) { return val * counts[val - min]; })
+            .sum();
+    } else {
+        aoc::hash_map<i64, i64> counts;
+        for (i64 val : vec2) {
+            ++counts[val];
+        }
+        return flux::ref(vec1)
+            .map([&](i64 val) {
+                auto iter = counts.find(val);
+                return iter == counts.end() ? 0 : val * iter->second;
+            })
+            .sum();
+    }
+};
+
+// Maintains both metrics as pairs of location IDs are added and removed. All
+// IDs must lie in the range [0, max_value) given on construction.
+//
+// The similarity score is the sum over all values v of v * left(v) * right(v),
+// where left and right are the histograms of the two lists, so an insertion or
+// removal changes it by a single term.
+//
+// For the distance, let D(t) be the number of left values <= t minus the
+// number of right values <= t. When the lists are the same length, the sum of
+// |L[i] - R[i]| over the sorted lists is equal to the sum of |D(t)| over all t.
+// Adding or removing a pair (a, b) adds +1 or -1 to D(t) for t between a and
+// b, and we keep the sum of |D| up to date using blocks of about
+// sqrt(max_value) values. Blocks which are entirely inside the range are
+// updated in O(1) using a lazy offset and a histogram of the D values within
+// the block; the (at most two) partially covered blocks are updated value by
+// value.
+struct online_lists {
+    explicit online_lists(i64 max_value)
+        : block_size_(std::max<i64>(std::sqrt(double(max_value)), 1)),
+          left_counts_(max_value),
+          right_counts_(max_value),
+          d_(max_value)
+    {
+        for (i64 start = 0; start < max_value; start += block_size_) {
+            i64 const size = std::min(block_size_, max_value - start);
+            block& blk = blocks_.emplace_back();
+            blk.size = size;
+            blk.non_negative = size;
+            blk.counts[0] = size;
+        }
+    }
+
+    void insert(i64 left, i64 right)
+    {
+        similarity_ += left * right_counts_.at(left);
+        ++left_counts_.at(left);
+        similarity_ += right * left_counts_.at(right);
+        ++right_counts_.at(right);
+        add_range(left, right, +1);
+    }
+
+    // The pair (left, right) must previously have been inserted
+    void erase(i64 left, i64 right)
+    {
+        --right_counts_.at(right);
+        similarity_ -= right * left_counts_.at(right);
+        --left_counts_.at(left);
+        similarity_ -= left * right_counts_.at(left);
+        add_range(left, right, -1);
+    }
+
+    auto distance() const -> i64
+    {
+        return flux::ref(blocks_).map(&block::abs_sum).sum();
+    }
+
+    auto similarity() const -> i64 { return similarity_; }
+
+private:
+    struct block {
+        i64 size = 0;
+        i64 offset = 0;       // D(t) is d_[t] + offset for every t in the block
+        i64 abs_sum = 0;      // Sum of |D(t)| over the block
+        i64 non_negative = 0; // Number of t in the block with D(t) >= 0
+        aoc::hash_map<i64, i64> counts; // Histogram of d_[t] within the block
+
+        auto count_where_d_is(i64 val) const -> i64
+        {
+            auto iter = counts.find(val - offset);
+            return iter == counts.end() ? 0 : iter->second;
+        }
+    };
+
+    // Inserting left and removing right (or vice versa) changes D by delta
+    // on [left, right), or by -delta on [right, left)
+    void add_range(i64 left, i64 right, int delta)
+    {
+        if (right < left) {
+            std::swap(left, right);
+            delta = -delta;
+        }
+
+        while (left < right) {
+            i64 const idx = left / block_size_;
+            i64 const block_start = idx * block_size_;
+            i64 const block_end = block_start + blocks_[idx].size;
+
+            if (left == block_start && right >= block_end) {
+                shift_block(blocks_[idx], delta);
+                left = block_end;
+            } else {
+                for (i64 const end = std::min(right, block_end); left < end;
+                     ++left) {
+                    add_one(blocks_[idx], left, delta);
+                }
+            }
+        }
+    }
+
+    static void shift_block(block& blk, int delta)
+    {
+        if (delta > 0) {
+            // Every D >= 0 moves away from zero, every D < 0 moves towards it,
+            // and the values which were -1 become non-negative
+            blk.abs_sum += blk.non_negative - (blk.size - blk.non_negative);
+            blk.non_negative += blk.count_where_d_is(-1);
+        } else {
+            i64 const positive = blk.non_negative - blk.count_where_d_is(0);
+            blk.abs_sum += (blk.size - positive) - positive;
+            blk.non_negative -= blk.count_where_d_is(0);
+        }
+        blk.offset += delta;
+    }
+
+    void add_one(block& blk, i64 t, int delta)
+    {
+        i64 const old_val = d_[t] + blk.offset;
+        i64 const new_val = old_val + delta;
+
+        --blk.counts[d_[t]];
+        d_[t] += delta;
+        ++blk.counts[d_[t]];
+
+        blk.abs_sum += std::abs(new_val) - std::abs(old_val);
+        blk.non_negative += i64(new_val >= 0) - i64(old_val >= 0);
+    }
+
+    i64 block_size_;
+    std::vector<i64> left_counts_;
+    std::vector<i64> right_counts_;
+    std::vector<i64> d_;
+    std::vector<block> blocks_;
+    i64 similarity_ = 0;
+};
+
+// Parses a line of the input as a pair of IDs for online_lists, or returns
+// nullopt if it isn't two numbers in the range [0, max_value)
+auto const parse_online_pair = [](std::string_view line, i64 max_value)
+    -> std::optional<std::pair<i64, i64>> {
+    auto const space = line.find(' ', 1);
+    if (space == line.npos) {
+        return std::nullopt;
+    }
+    auto const left = aoc::try_parse<i64>(line.substr(0, space));
+    auto const right = aoc::try_parse<i64>(line.substr(space));
+    auto const in_range = [max_value](std::optional<i64> id) {
+        return id && *id >= 0 && *id < max_value;
+    };
+    if (!in_range(left) || !in_range(right)) {
+        return std::nullopt;
+    }
+    return std::pair(*left, *right);
 };
 
 constexpr auto& test_data =
@@ -53,17 +319,103 @@ static_assert([] {
     return part1(v1, v2) == 11 && part2(v1, v2) == 31;
 }());
 
+static_assert([] {
+    std::vector<i64> vec{5, -3, 1LL << 40, 0, -(1LL << 50), 7, 5};
+    radix_sort(vec);
+    return std::ranges::is_sorted(vec);
+}());
+
+static_assert([] {
+    auto [v1, v2] = parse_input(test_data);
+    sort_columns(v1, v2);
+    return distance_sorted(v1, v2) == 11 && similarity_sorted(v1, v2) == 31;
+}());
+
 } // namespace
 
 int main(int argc, char** argv)
 {
-    if (argc != 2) {
+    // Online tests: insert the example pairs one at a time, then remove some
+    {
+        auto [v1, v2] = parse_input(test_data);
+        online_lists online(10);
+        for (auto [l, r] : flux::zip(flux::ref(v1), flux::ref(v2))) {
+            online.insert(l, r);
+        }
+        assert(online.distance() == 11);
+        assert(online.similarity() == 31);
+
+        online.erase(v1.front(), v2.front());
+        online.erase(v1.back(), v2.back());
+        v1 = std::vector<i64>(v1.begin() + 1, v1.end() - 1);
+        v2 = std::vector<i64>(v2.begin() + 1, v2.end() - 1);
+        assert(online.distance() == part1(v1, v2));
+        assert(online.similarity() == part2(v1, v2));
+
+        assert((parse_online_pair("3   4", 10) == std::pair<i64, i64>(3, 4)));
+        assert(!parse_online_pair("3", 10));
+        assert(!parse_online_pair("3   10", 10));
+        assert(!parse_online_pair("-1   4", 10));
+    }
+
+    // SIMD tests: the static_asserts only reach the scalar code, so compare
+    // the vectorised sum against a plain loop, with a length which leaves a
+    // partial batch at the end
+    {
+        std::vector<i64> a;
+        std::vector<i64> b;
+        for (i64 i = 0; i < 37; ++i) {
+            a.push_back(i * 7919 % 1000);
+            b.push_back(i * 104729 % 1000);
+        }
+        i64 expected = 0;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            expected += std::abs(a[i] - b[i]);
+        }
+        assert(aoc::simd::transform_sum(a, b, [](auto x, auto y) {
+                   return aoc::simd::abs(x - y);
+               }) == expected);
+    }
+
+    if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
     }
 
+    // Online mode: treat each line of the input as a new pair arriving, and
+    // report both metrics after each one
+    if (auto const arg = aoc::get_option(argc, argv, "--online")) {
+        i64 const max_value = aoc::try_parse<i64>(*arg).value_or(0);
+        if (max_value <= 0) {
+            std::println(stderr, "--online needs a positive maximum ID");
+            return -1;
+        }
+
+        online_lists online(max_value);
+        std::ifstream file(argv[1]);
+        int line_no = 0;
+        for (std::string line; std::getline(file, line);) {
+            ++line_no;
+            if (line.empty()) {
+                continue;
+            }
+            auto const pair = parse_online_pair(line, max_value);
+            if (!pair) {
+                std::println(stderr, "Line {} is not a pair of IDs in [0, {})",
+                             line_no, max_value);
+                return -1;
+            }
+            online.insert(pair->first, pair->second);
+            std::println("{} {}", online.distance(), online.similarity());
+        }
+        return 0;
+    }
+
     auto [vec1, vec2] = parse_input(aoc::string_from_file(argv[1]));
 
-    std::println("Part 1: {}", part1(vec1, vec2));
-    std::println("Part 2: {}", part2(vec1, vec2));
+    // Sort once, and use the sorted vectors for both parts
+    sort_columns(vec1, vec2);
+
+    std::println("Part 1: {}", distance_sorted(vec1, vec2));
+    std::println("Part 2: {}", similarity_sorted(vec1, vec2));
 }
\ No newline at end of file
@@ -1,53 +1,279 @@
 
 #include <aoc.hpp>
 
+#include <stdexcept>
+
 namespace {
 
-auto parse_input = [](std::string_view input) -> std::vector<std::vector<int>> {
-    return flux::split_string(input, '\n')
+using level_t = std::int8_t;
+
+// All of the reports' levels stored back to back, so that report i is the
+// range [offsets[i], offsets[i + 1]) of levels
+struct reports_t {
+    std::vector<level_t> levels;
+    std::vector<std::uint32_t> offsets{0};
+
+    constexpr auto size() const -> std::size_t { return offsets.size() - 1; }
+
+    constexpr auto operator[](std::size_t i) const -> std::span<level_t const>
+    {
+        return std::span(levels).subspan(offsets[i],
+                                         offsets[i + 1] - offsets[i]);
+    }
+};
+
+auto parse_input = [](std::string_view input) -> reports_t {
+    reports_t reports;
+    flux::split_string(input, '\n')
         .filter([](std::string_view line) { return !line.empty(); })
-        .map([](std::string_view line) {
-            return flux::split_string(line, ' ')
-                .map(aoc::parse<int>)
-                .to<std::vector<int>>();
-        })
-        .to<std::vector>();
+        .for_each([&](std::string_view line) {
+            flux::split_string(line, ' ').for_each([&](std::string_view str) {
+                int const level = aoc::parse<int>(str);
+                // Checked in release builds too, as a level which didn't fit
+                // would silently wrap and change the answers
+                if (!std::in_range<level_t>(level)) {
+                    throw std::out_of_range("Level out of range: "
+                                            + std::string(str));
+                }
+                reports.levels.push_back(level_t(level));
+            });
+            reports.offsets.push_back(reports.levels.size());
+        });
+    return reports;
+};
+
+// Version of the layout of our pre-parsed input cache
+constexpr std::uint32_t cache_version = 2;
+
+// The cache holds the two arrays of reports_t as they are
+auto const save_cache = [](reports_t const& reports, aoc::cache::writer& out) {
+    out.add(reports.levels);
+    out.add(reports.offsets);
+};
+
+auto const load_cache
+    = [](aoc::cache::reader const& in) -> std::optional<reports_t> {
+    auto const levels = in.section<level_t>(0);
+    auto const offsets = in.section<std::uint32_t>(1);
+    if (!levels || !offsets
+        || !aoc::cache::offsets_valid(*offsets, levels->size())) {
+        return std::nullopt;
+    }
+    return reports_t{.levels = {levels->begin(), levels->end()},
+                     .offsets = {offsets->begin(), offsets->end()}};
+};
+
+constexpr auto no_skip = std::size_t(-1);
+
+// Returns the index of the level which ends the first invalid step of the
+// report in the given direction, ignoring the level at index skip
+auto const first_bad_step = [](std::span<level_t const> report, int dir,
+                               std::size_t skip) -> std::optional<std::size_t> {
+    std::optional<int> prev;
+    for (std::size_t i = 0; i < report.size(); i++) {
+        if (i == skip) {
+            continue;
+        }
+        if (prev) {
+            int const diff = (report[i] - *prev) * dir;
+            if (diff < 1 || diff > 3) {
+                return i;
+            }
+        }
+        prev = report[i];
+    }
+    return std::nullopt;
+};
+
+struct verdict {
+    bool safe = false;
+    bool dampened = false;
+};
+
+// If removing a single level fixes a report, that level must be one of the
+// two either side of its first bad step, so we only need to try those
+auto const check_report = [](std::span<level_t const> report) -> verdict {
+    verdict v;
+    for (int dir : {1, -1}) {
+        auto const bad = first_bad_step(report, dir, no_skip);
+        if (!bad) {
+            return {.safe = true, .dampened = true};
+        }
+        v.dampened = v.dampened || !first_bad_step(report, dir, *bad - 1)
+            || !first_bad_step(report, dir, *bad);
+    }
+    return v;
+};
+
+auto const solve_scalar = [](reports_t const& reports) -> std::pair<int, int> {
+    std::pair sum(0, 0);
+    for (std::size_t i = 0; i < reports.size(); i++) {
+        auto const v = check_report(reports[i]);
+        sum.first += v.safe;
+        sum.second += v.dampened;
+    }
+    return sum;
+};
+
+#ifdef AOC_HAVE_STD_SIMD
+namespace stdx = aoc::simd::stdx;
+
+using batch_t = aoc::simd::native<std::int16_t>;
+using batch_mask_t = batch_t::mask_type;
+
+// Reports with at most this many levels are checked in batches, one per lane
+constexpr std::size_t max_batched_levels = 8;
+
+// Level j of each report in a batch is held in lane i of columns[j]
+using columns_t = std::array<batch_t, max_batched_levels>;
+
+// Returns the lanes whose first n levels form a safe report
+auto const batch_safe = [](columns_t const& cols, batch_t const& n) {
+    batch_mask_t inc(true);
+    batch_mask_t dec(true);
+    for (std::size_t j = 0; j + 1 < max_batched_levels; j++) {
+        batch_t const diff = cols[j + 1] - cols[j];
+        batch_mask_t const active = batch_t(std::int16_t(j + 1)) < n;
+        inc = inc && ((diff >= 1 && diff <= 3) || !active);
+        dec = dec && ((diff >= -3 && diff <= -1) || !active);
+    }
+    return inc || dec;
 };
 
-auto abs_diff = []<flux::num::integral T>(T const& lhs, T const& rhs) -> T {
-    T diff = flux::num::sub(lhs, rhs);
-    return diff < T{0} ? flux::num::neg(diff) : diff;
+// Returns the lanes which are safe with at most one level removed, by trying
+// each removal in turn across the whole batch
+auto const batch_dampened
+    = [](columns_t const& cols, batch_t const& n, batch_mask_t safe) {
+    for (std::size_t k = 0; k < max_batched_levels && !stdx::all_of(safe);
+         k++) {
+        columns_t removed = cols;
+        for (std::size_t j = k; j + 1 < max_batched_levels; j++) {
+            removed[j] = cols[j + 1];
+        }
+        safe = safe || batch_safe(removed, n - 1);
+    }
+    return safe;
 };
 
-auto is_sorted
-    = [](flux::multipass_sequence auto const& seq, auto cmp) -> bool {
-    return flux::ref(seq).pairwise_map(cmp).all(std::identity{});
+// Transposes up to batch_t::size() short reports into columns and checks them
+// all at once. Longer reports are checked one at a time.
+auto const solve_batched
+    = [](reports_t const& reports) -> std::pair<int, int> {
+    constexpr std::size_t width = batch_t::size();
+    std::array<std::int16_t, max_batched_levels * width> buf{};
+    std::array<std::int16_t, width> lengths{};
+    std::size_t n_lanes = 0;
+    std::pair sum(0, 0);
+
+    auto flush = [&] {
+        columns_t cols;
+        for (std::size_t j = 0; j < max_batched_levels; j++) {
+            cols[j].copy_from(buf.data() + j * width, stdx::element_aligned);
+        }
+        batch_t const n(lengths.data(), stdx::element_aligned);
+        batch_mask_t const used
+            = aoc::simd::lane_indices<std::int16_t> < std::int16_t(n_lanes);
+        auto const safe = batch_safe(cols, n) && used;
+        sum.first += stdx::popcount(safe);
+        sum.second += stdx::popcount(batch_dampened(cols, n, safe) && used);
+        n_lanes = 0;
+    };
+
+    for (std::size_t i = 0; i < reports.size(); i++) {
+        auto const report = reports[i];
+        if (report.size() > max_batched_levels) {
+            auto const v = check_report(report);
+            sum.first += v.safe;
+            sum.second += v.dampened;
+            continue;
+        }
+        for (std::size_t j = 0; j < report.size(); j++) {
+            buf[j * width + n_lanes] = report[j];
+        }
+        lengths[n_lanes] = std::int16_t(report.size());
+        if (++n_lanes == width) {
+            flush();
+        }
+    }
+    if (n_lanes > 0) {
+        flush();
+    }
+    return sum;
 };
+#endif
 
-auto is_safe = [](flux::multipass_sequence auto const& seq) -> bool {
-    return (is_sorted(seq, std::less{}) || is_sorted(seq, std::greater{}))
-        && flux::ref(seq).pairwise_map(abs_diff).all(flux::pred::geq(1)
-                                                     && flux::pred::leq(3));
+// Returns the verdicts for both parts from a single pass over the reports
+auto const solve = [](reports_t const& reports) -> std::pair<int, int> {
+    if consteval {
+        return solve_scalar(reports);
+    } else {
+#ifdef AOC_HAVE_STD_SIMD
+        return solve_batched(reports);
+#else
+        return solve_scalar(reports);
+#endif
+    }
+};
+
+auto part1 = [](reports_t const& reports) -> int {
+    return solve(reports).first;
+};
+
+auto part2 = [](reports_t const& reports) -> int {
+    return solve(reports).second;
+};
+
+// Returns the fewest levels which must be removed to make the report safe,
+// or some number greater than max_removals if that can't be done. best[i] is
+// the fewest removals from the first i + 1 levels which leave a safe sequence
+// ending in level i, so only the previous max_removals + 1 levels can precede
+// it in any solution we care about.
+auto const min_removals
+    = [](std::span<level_t const> report, int max_removals) -> int {
+    int const n = int(report.size());
+    int result = std::max(n - 1, 0);
+    std::vector<int> best(n);
+    for (int dir : {1, -1}) {
+        for (int i = 0; i < n; i++) {
+            best[i] = i;
+            for (int j = std::max(0, i - max_removals - 1); j < i; j++) {
+                int const diff = (report[i] - report[j]) * dir;
+                if (diff >= 1 && diff <= 3) {
+                    best[i] = std::min(best[i], best[j] + (i - j - 1));
+                }
+            }
+            result = std::min(result, best[i] + (n - 1 - i));
+        }
+    }
+    return result;
 };
 
-// Returns an adapted sequence which skips the element at index n
-auto skip_n = [](flux::sequence auto&& seq, flux::index_t n) {
-    return flux::zip(FLUX_FWD(seq), flux::ints())
-        .filter([n](auto pair) { return pair.second != n; })
-        .map([](auto pair) -> decltype(auto) { return pair.first; });
+// Returns a predicate testing whether a report can be made safe by removing
+// at most max_removals levels
+auto const tolerates = [](int max_removals) {
+    return [max_removals](std::span<level_t const> report) -> bool {
+        return min_removals(report, max_removals) <= max_removals;
+    };
 };
 
-auto part1 = [](std::vector<std::vector<int>> const& vec) -> int {
-    return flux::count_if(vec, is_safe);
+auto const count_tolerable
+    = [](reports_t const& reports, int max_removals) -> int {
+    return flux::ints(0, reports.size())
+        .map([&reports](auto i) { return reports[i]; })
+        .count_if(tolerates(max_removals));
 };
 
-auto part2 = [](std::vector<std::vector<int>> const& vec) -> int {
-    return flux::count_if(vec, [](auto const& report) -> bool {
-        return is_safe(report)
-            || flux::ints(0, report.size())
-                   .map([r = flux::ref(report)](int i) { return skip_n(r, i); })
-                   .any(is_safe);
-    });
+// Parses and solves each block of lines on a separate thread
+auto const solve_parallel = [](std::string_view input) -> std::pair<int, int> {
+    return aoc::parallel_fold_lines(
+        input,
+        [](std::string_view chunk) {
+            return solve(parse_input(chunk));
+        },
+        std::pair(0, 0),
+        [](std::pair<int, int> sum, std::pair<int, int> next) {
+            return std::pair(sum.first + next.first, sum.second + next.second);
+        });
 };
 
 constexpr auto& test_data =
@@ -64,17 +290,63 @@ static_assert([] {
     return part1(vec) == 2 && part2(vec) == 4;
 }());
 
+static_assert([] {
+    auto vec = parse_input(test_data);
+    return count_tolerable(vec, 0) == 2 && count_tolerable(vec, 1) == 4
+        && count_tolerable(vec, 2) == 6;
+}());
+
+static_assert([] {
+    auto vec = parse_input(test_data);
+    return min_removals(vec[1], 4) == 2 && min_removals(vec[3], 4) == 1
+        && min_removals(vec[5], 4) == 0;
+}());
+
 } // namespace
 
 int main(int argc, char** argv)
 {
+    assert((solve_parallel(test_data) == std::pair(2, 4)));
+
+    // Levels which don't fit in a level_t are rejected rather than wrapped
+    [[maybe_unused]] bool rejected = false;
+    try {
+        parse_input("1 2 300\n");
+    } catch (std::out_of_range const&) {
+        rejected = true;
+    }
+    assert(rejected);
+
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
     }
 
-    auto const input = parse_input(aoc::string_from_file(argv[1]));
+    try {
+        if (auto const k = aoc::get_option(argc, argv, "--tolerance")) {
+            int const max_removals = aoc::parse<int>(*k);
+            auto const reports = parse_input(aoc::string_from_file(argv[1]));
+            std::println("Safe with up to {} removals: {}", max_removals,
+                         count_tolerable(reports, max_removals));
+            return 0;
+        }
+
+        if (aoc::has_flag(argc, argv, "--cache")) {
+            auto const reports = aoc::parse_cached(argv[1], cache_version,
+                                                   parse_input, save_cache,
+                                                   load_cache);
+            auto const [p1, p2] = solve(reports);
+            std::println("Part 1: {}", p1);
+            std::println("Part 2: {}", p2);
+            return 0;
+        }
 
-    std::println("Part 1: {}", part1(input));
-    std::println("Part 2: {}", part2(input));
+        auto const [p1, p2] = solve_parallel(aoc::string_from_file(argv[1]));
+
+        std::println("Part 1: {}", p1);
+        std::println("Part 2: {}", p2);
+    } catch (std::out_of_range const& e) {
+        std::println(stderr, "{}", e.what());
+        return -1;
+    }
 }
\ No newline at end of file
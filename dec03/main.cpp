@@ -1,32 +1,263 @@
-
 #include <aoc.hpp>
 
-#include <ctre.hpp>
-
 namespace {
 
-auto part1 = [](std::string_view input) -> int {
-    constexpr auto& regex = R"(mul\((\d{1,3}),(\d{1,3})\))";
+using i64 = std::int64_t;
+
+// A hand-written state machine which recognises mul(a,b), do() and don't(),
+// tracking the sum of all the products for part 1 and of the enabled ones for
+// part 2 as it goes.
+struct scanner {
+    i64 sum_all = 0;
+    i64 sum_enabled = 0;
+    i64 sum_untoggled = 0; // Products before the first do() or don't()
+    bool enabled = true;
+    bool toggled = false;
+
+    constexpr auto in_progress() const -> bool
+    {
+        return state_ != state::idle;
+    }
+
+    // Feeds a single character to the state machine. Returns false if the
+    // character did not continue the instruction in progress, in which case
+    // the scanner is reset and the character must be fed again.
+    constexpr auto step(char c) -> bool
+    {
+        auto expect = [&](char want, state next) {
+            if (c != want) {
+                return mismatch();
+            }
+            state_ = next;
+            return true;
+        };
+
+        switch (state_) {
+        case state::idle:
+            if (c == 'm') {
+                state_ = state::m;
+            } else if (c == 'd') {
+                state_ = state::d;
+            }
+            return true;
+        case state::m: return expect('u', state::mu);
+        case state::mu: return expect('l', state::mul);
+        case state::mul:
+            lhs_ = rhs_ = digits_ = 0;
+            return expect('(', state::lhs);
+        case state::lhs:
+            if (read_digit(c, lhs_)) {
+                return true;
+            }
+            if (digits_ == 0) {
+                return mismatch();
+            }
+            digits_ = 0;
+            return expect(',', state::rhs);
+        case state::rhs:
+            if (read_digit(c, rhs_)) {
+                return true;
+            }
+            if (digits_ == 0 || c != ')') {
+                return mismatch();
+            }
+            sum_all += lhs_ * rhs_;
+            sum_enabled += enabled ? lhs_ * rhs_ : 0;
+            sum_untoggled += toggled ? 0 : lhs_ * rhs_;
+            state_ = state::idle;
+            return true;
+        case state::d: return expect('o', state::do_);
+        case state::do_:
+            if (c == 'n') {
+                state_ = state::don;
+                return true;
+            }
+            return expect('(', state::do_open);
+        case state::do_open:
+            if (c == ')') {
+                enabled = true;
+                toggled = true;
+            }
+            return expect(')', state::idle);
+        case state::don: return expect('\'', state::don_q);
+        case state::don_q: return expect('t', state::dont);
+        case state::dont: return expect('(', state::dont_open);
+        case state::dont_open:
+            if (c == ')') {
+                enabled = false;
+                toggled = true;
+            }
+            return expect(')', state::idle);
+        }
+        return mismatch();
+    }
+
+    // Scans all of input. Between instructions, we use SIMD to skip straight to
+    // the next 'm' or 'd', as no other byte can start one.
+    constexpr void scan(std::string_view input)
+    {
+        std::size_t i = 0;
+        while (i < input.size()) {
+            if (state_ == state::idle) {
+                auto const block = input.substr(i, 64);
+                std::uint64_t const starts = aoc::simd::match_mask(block, 'm')
+                    | aoc::simd::match_mask(block, 'd');
+                if (starts == 0) {
+                    i += block.size();
+                    continue;
+                }
+                i += std::countr_zero(starts);
+            }
+            if (step(input[i])) {
+                ++i;
+            }
+        }
+    }
+
+private:
+    enum class state : std::uint8_t {
+        idle,
+        m,
+        mu,
+        mul,
+        lhs,
+        rhs,
+        d,
+        do_,
+        do_open,
+        don,
+        don_q,
+        dont,
+        dont_open,
+    };
+
+    state state_ = state::idle;
+    i64 lhs_ = 0;
+    i64 rhs_ = 0;
+    int digits_ = 0;
+
+    constexpr auto mismatch() -> bool
+    {
+        state_ = state::idle;
+        return false;
+    }
+
+    // Appends c to the number if it's a digit and the number has fewer than
+    // three digits so far
+    constexpr auto read_digit(char c, i64& num) -> bool
+    {
+        if (c < '0' || c > '9' || digits_ == 3) {
+            return false;
+        }
+        num = num * 10 + (c - '0');
+        ++digits_;
+        return true;
+    }
+};
+
+// Returns the answers to both parts from a single pass over the input
+auto solve = [](std::string_view input) -> std::pair<i64, i64> {
+    scanner scan;
+    scan.scan(input);
+    return {scan.sum_all, scan.sum_enabled};
+};
+
+// Feeds the input to the scanner in pieces of at most chunk_size bytes. As the
+// scanner keeps its state between calls, this must give the same result as
+// scanning the whole input at once.
+auto solve_chunked = [](std::string_view input,
+                        std::size_t chunk_size) -> std::pair<i64, i64> {
+    scanner scan;
+    for (std::size_t i = 0; i < input.size(); i += chunk_size) {
+        scan.scan(input.substr(i, chunk_size));
+    }
+    return {scan.sum_all, scan.sum_enabled};
+};
+
+// Reads the file at path a chunk at a time, so that memory use depends only on
+// chunk_size and not on the size of the file
+auto solve_file = [](char const* path,
+                     std::size_t chunk_size) -> std::pair<i64, i64> {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> buffer(chunk_size);
+    scanner scan;
+    while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+        scan.scan(std::string_view(buffer.data(), file.gcount()));
+    }
+    return {scan.sum_all, scan.sum_enabled};
+};
+
+// What a chunk of the input contributes to the answers, given that we don't
+// know whether instructions are enabled at its start
+struct chunk_summary {
+    i64 sum_all = 0;
+    i64 sum_untoggled = 0; // Products before the chunk's first do() or don't()
+    i64 sum_toggled = 0;   // Enabled products after it
+    bool toggled = false;
+    bool enabled = false; // The state at the end of the chunk, if toggled
+};
+
+// Splits [0, size) into n ranges of about the same length
+auto chunk_bounds = [](std::size_t size, std::size_t n)
+    -> std::vector<std::pair<std::size_t, std::size_t>> {
+    std::vector<std::pair<std::size_t, std::size_t>> bounds;
+    for (std::size_t i = 0; i < n; i++) {
+        bounds.emplace_back(size * i / n, size * (i + 1) / n);
+    }
+    return bounds;
+};
+
+// Summarises the instructions which start in [from, to). If one is still in
+// progress at the end, we read on until it completes or fails, but don't start
+// any more: those belong to the next chunk. A chunk which starts part way
+// through an instruction never mistakes its tail for a new one, as none of
+// the instructions contain an 'm' or 'd' after their first character.
+auto summarise_chunk = [](std::string_view input, std::size_t from,
+                          std::size_t to) -> chunk_summary {
+    scanner scan;
+    scan.scan(input.substr(from, to - from));
+    for (std::size_t i = to;
+         i < input.size() && scan.in_progress() && scan.step(input[i]); i++) {
+    }
+    return {.sum_all = scan.sum_all,
+            .sum_untoggled = scan.sum_untoggled,
+            .sum_toggled = scan.sum_enabled - scan.sum_untoggled,
+            .toggled = scan.toggled,
+            .enabled = scan.enabled};
+};
 
-    return flux::from_range(ctre::search_all<regex>(input))
-        .map([](auto result) {
-            auto [_, a, b] = result;
-            return a.to_number() * b.to_number();
-        })
-        .sum();
+// A chunk starts in the state left by the last chunk before it which saw a
+// do() or don't(), so one pass from the left resolves the part 2 total
+auto combine_chunks
+    = [](std::span<chunk_summary const> chunks) -> std::pair<i64, i64> {
+    std::pair<i64, i64> total{0, 0};
+    bool enabled = true;
+    for (chunk_summary const& chunk : chunks) {
+        total.first += chunk.sum_all;
+        total.second += (enabled ? chunk.sum_untoggled : 0) + chunk.sum_toggled;
+        if (chunk.toggled) {
+            enabled = chunk.enabled;
+        }
+    }
+    return total;
 };
 
-auto part2 = [](std::string_view input) -> int {
-    return flux::split_string(input, "do()")
-        .map([](std::string_view chunk) {
-            return flux::split_string(chunk, "don't()")
-                .front()
-                .map(part1)
-                .value();
-        })
-        .sum();
+// Scans the input in n_chunks pieces on separate threads
+auto const solve_parallel
+    = [](std::string_view input, std::size_t n_chunks) -> std::pair<i64, i64> {
+    auto const summaries
+        = aoc::parallel_map(chunk_bounds(input.size(), n_chunks),
+                            [input](std::pair<std::size_t, std::size_t> r) {
+                                return summarise_chunk(input, r.first,
+                                                       r.second);
+                            });
+    return combine_chunks(summaries);
 };
 
+auto part1 = [](std::string_view input) -> i64 { return solve(input).first; };
+
+auto part2 = [](std::string_view input) -> i64 { return solve(input).second; };
+
 constexpr auto& test_input1
     = R"(xmul(2,4)%&mul[3,7]!@^do_not_mul(5,5)+mul(32,64]then(mul(11,8)mul(8,5)))";
 
@@ -36,17 +267,101 @@ constexpr auto& test_input2
 static_assert(part1(test_input1) == 161);
 static_assert(part2(test_input2) == 48);
 
+// Try every chunk size, so that each instruction is split at every point
+static_assert([] {
+    auto for_all_sizes = [](std::string_view input, auto check) {
+        for (std::size_t size = 1; size <= input.size(); size++) {
+            if (!check(solve_chunked(input, size))) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return for_all_sizes(test_input1, [](auto r) { return r.first == 161; })
+        && for_all_sizes(test_input2, [](auto r) { return r.second == 48; });
+}());
+
+// Check the chunked summaries against every way of splitting the examples
+static_assert([] {
+    auto for_all_splits = [](std::string_view input, auto check) {
+        for (std::size_t n = 1; n <= input.size(); n++) {
+            std::vector<chunk_summary> chunks;
+            for (auto [from, to] : chunk_bounds(input.size(), n)) {
+                chunks.push_back(summarise_chunk(input, from, to));
+            }
+            if (!check(combine_chunks(chunks))) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return for_all_splits(test_input1, [](auto r) { return r.first == 161; })
+        && for_all_splits(test_input2, [](auto r) { return r.second == 48; });
+}());
+
 } // namespace
 
 int main(int argc, char** argv)
 {
+    // SIMD tests: the static_asserts only reach the scalar code, so check the
+    // 64-byte block path against a plain loop, with matches in every quarter
+    {
+        std::string block(64, 'x');
+        for (std::size_t i : {3, 20, 40, 63}) {
+            block[i] = 'm';
+        }
+        std::uint64_t expected = 0;
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            expected |= std::uint64_t(block[i] == 'm') << i;
+        }
+        assert(aoc::simd::match_mask(block, 'm') == expected);
+
+        std::string repeated;
+        for (int i = 0; i < 10; ++i) {
+            repeated += test_input1;
+        }
+        assert(solve(repeated).first == 10 * 161);
+    }
+
+    {
+        // An empty file maps to an empty input, rather than failing to open
+        auto const path
+            = std::filesystem::temp_directory_path() / "aoc-dec03-empty.txt";
+        std::ofstream{path};
+        auto const file = aoc::mapped_file::open(path.c_str());
+        assert(file && file->bytes().empty());
+        std::filesystem::remove(path);
+    }
+
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
     }
 
-    auto const input = aoc::string_from_file(argv[1]);
+    assert(solve_parallel(test_input2, aoc::thread_count()).second == 48);
+
+    if (aoc::has_flag(argc, argv, "--parallel")) {
+        auto const file = aoc::mapped_file::open(argv[1]);
+        if (!file) {
+            std::println(stderr, "Could not open {}", argv[1]);
+            return -1;
+        }
+        std::string_view const input(
+            reinterpret_cast<char const*>(file->bytes().data()),
+            file->bytes().size());
+        auto const [p1, p2] = solve_parallel(input, aoc::thread_count());
+        std::println("Part 1: {}", p1);
+        std::println("Part 2: {}", p2);
+        return 0;
+    }
+
+    std::size_t chunk_size = 1 << 20;
+    if (auto const opt = aoc::get_option(argc, argv, "--chunk-size")) {
+        chunk_size = std::max(aoc::parse<int>(*opt), 1);
+    }
+
+    auto const [p1, p2] = solve_file(argv[1], chunk_size);
 
-    std::println("Part 1: {}", part1(input));
-    std::println("Part 2: {}", part2(input));
-}
\ No newline at end of file
+    std::println("Part 1: {}", p1);
+    std::println("Part 2: {}", p2);
+}
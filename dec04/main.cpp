@@ -3,22 +3,18 @@
 
 namespace {
 
-using namespace std::string_view_literals;
-
 using i64 = std::int64_t;
 
+using u64 = std::uint64_t;
+
 struct grid2d {
     std::string data;
     i64 width;
     i64 height;
 
-    // Returns '.' if (x, y) is out of bounds
-    constexpr auto operator[](i64 x, i64 y) const -> char
+    constexpr auto row(i64 y) const -> std::string_view
     {
-        if (x < 0 || x >= width || y < 0 || y >= height) {
-            return '.';
-        }
-        return data.at(y * width + x);
+        return std::string_view(data).substr(y * width, width);
     }
 };
 
@@ -29,36 +25,341 @@ auto const parse_input = [](std::string_view input) -> grid2d {
         .height = flux::count_eq(input, '\n')};
 };
 
-auto const neighbours = [](grid2d const& grid, i64 x, i64 y) {
-    return flux::cartesian_power<2>(flux::ints(-1, 2))
-        .filter(flux::unpack([](i64 i, i64 j) { return !(i == 0 && j == 0); }))
-        .map(flux::unpack([&grid, x, y](i64 i, i64 j) -> std::string {
-            return {grid[x + i, y + j], grid[x + 2 * i, y + 2 * j],
-                    grid[x + 3 * i, y + 3 * j]};
-        }));
+constexpr std::string_view letters = "XMAS";
+
+// For each of the letters X, M, A and S, a bitmask of the columns of a row in
+// which it appears, 64 columns to a word
+using row_masks = std::array<std::span<u64 const>, 4>;
+
+constexpr auto words_per_row(i64 width) -> std::size_t
+{
+    return (width + 63) / 64;
+}
+
+// Fills out, which holds 4 * words_per_row(row.size()) words, with the masks
+// for each letter in turn
+constexpr auto fill_row_masks = [](std::string_view row, std::span<u64> out) {
+    std::size_t const words = words_per_row(row.size());
+    for (std::size_t i = 0; i < letters.size(); i++) {
+        for (std::size_t w = 0; w < words; w++) {
+            out[i * words + w]
+                = aoc::simd::match_mask(row.substr(w * 64, 64), letters[i]);
+        }
+    }
 };
 
-auto const part1 = [](grid2d const& grid) -> i64 {
-    return flux::cartesian_product(flux::ints(0, grid.height),
-                                   flux::ints(0, grid.width))
-        .filter(flux::unpack([&](i64 x, i64 y) { return grid[x, y] == 'X'; }))
-        .map(flux::unpack([&](i64 x, i64 y) { return neighbours(grid, x, y); }))
-        .flatten()
-        .count_if(flux::pred::eq("MAS"sv));
+constexpr auto split_row_masks = [](std::span<u64 const> masks) -> row_masks {
+    std::size_t const words = masks.size() / 4;
+    return {masks.subspan(0, words), masks.subspan(words, words),
+            masks.subspan(2 * words, words), masks.subspan(3 * words, words)};
 };
 
-auto const part2 = [](grid2d const& grid) -> i64 {
-    return flux::cartesian_product(flux::ints(0, grid.height - 2),
-                                   flux::ints(0, grid.width - 2))
-        .count_if(flux::unpack([&grid](i64 x, i64 y) {
-            std::string lead{grid[x, y], grid[x + 1, y + 1],
-                             grid[x + 2, y + 2]};
-            std::string back{grid[x + 2, y], grid[x + 1, y + 1],
-                             grid[x, y + 2]};
-
-            return (lead == "MAS" || lead == "SAM")
-                && (back == "MAS" || back == "SAM");
-        }));
+// The row masks for every row of a grid, stored contiguously
+struct bit_grid {
+    i64 width = 0;
+    i64 height = 0;
+    std::vector<u64> bits = std::vector<u64>(4 * words_per_row(width) * height);
+
+    constexpr auto row(i64 y) const -> row_masks
+    {
+        std::size_t const stride = 4 * words_per_row(width);
+        return split_row_masks(std::span(bits).subspan(y * stride, stride));
+    }
+};
+
+auto const make_bit_grid = [](grid2d const& grid) -> bit_grid {
+    bit_grid out{.width = grid.width, .height = grid.height};
+    std::size_t const stride = 4 * words_per_row(grid.width);
+    for (i64 y = 0; y < grid.height; y++) {
+        fill_row_masks(grid.row(y),
+                       std::span(out.bits).subspan(y * stride, stride));
+    }
+    return out;
+};
+
+// Returns word w of a row mask shifted so that bit x holds column x + shift,
+// with zeros for columns outside the row. shift must be in [-63, 63].
+constexpr auto shifted = [](std::span<u64 const> mask, std::size_t w,
+                            int shift) -> u64 {
+    if (shift > 0) {
+        u64 const next = w + 1 < mask.size() ? mask[w + 1] : 0;
+        return (mask[w] >> shift) | (next << (64 - shift));
+    } else if (shift < 0) {
+        u64 const prev = w > 0 ? mask[w - 1] : 0;
+        return (mask[w] << -shift) | (prev >> (64 + shift));
+    }
+    return mask[w];
+};
+
+// Counts XMAS forwards and backwards within a single row
+constexpr auto count_horizontal = [](row_masks const& row) -> i64 {
+    i64 count = 0;
+    for (std::size_t w = 0; w < row[0].size(); w++) {
+        for (int dx : {-1, 1}) {
+            count += std::popcount(row[0][w] & shifted(row[1], w, dx)
+                                   & shifted(row[2], w, 2 * dx)
+                                   & shifted(row[3], w, 3 * dx));
+        }
+    }
+    return count;
+};
+
+// Counts XMAS in the six vertical and diagonal directions, running from the
+// first to the last of four consecutive rows in either direction
+constexpr auto count_spanning
+    = [](std::array<row_masks, 4> const& rows) -> i64 {
+    i64 count = 0;
+    for (std::size_t w = 0; w < rows[0][0].size(); w++) {
+        for (int dx : {-1, 0, 1}) {
+            u64 down = ~u64{0};
+            u64 up = ~u64{0};
+            for (int i = 0; i < 4; i++) {
+                down &= shifted(rows[i][i], w, i * dx);
+                up &= shifted(rows[i][3 - i], w, i * dx);
+            }
+            count += std::popcount(down) + std::popcount(up);
+        }
+    }
+    return count;
+};
+
+// Counts the crosses of two MAS centred on the middle of three rows
+constexpr auto count_crosses = [](std::array<row_masks, 3> const& rows) -> i64 {
+    constexpr std::size_t M = 1, A = 2, S = 3;
+    auto const& [above, middle, below] = rows;
+    i64 count = 0;
+    for (std::size_t w = 0; w < middle[A].size(); w++) {
+        u64 const lead = (shifted(above[M], w, -1) & shifted(below[S], w, 1))
+            | (shifted(above[S], w, -1) & shifted(below[M], w, 1));
+        u64 const back = (shifted(above[M], w, 1) & shifted(below[S], w, -1))
+            | (shifted(above[S], w, 1) & shifted(below[M], w, -1));
+        count += std::popcount(middle[A][w] & lead & back);
+    }
+    return count;
+};
+
+auto const part1 = [](bit_grid const& grid) -> i64 {
+    i64 count = 0;
+    for (i64 y = 0; y < grid.height; y++) {
+        count += count_horizontal(grid.row(y));
+        if (y >= 3) {
+            count += count_spanning({grid.row(y - 3), grid.row(y - 2),
+                                     grid.row(y - 1), grid.row(y)});
+        }
+    }
+    return count;
+};
+
+auto const part2 = [](bit_grid const& grid) -> i64 {
+    i64 count = 0;
+    for (i64 y = 2; y < grid.height; y++) {
+        count += count_crosses({grid.row(y - 2), grid.row(y - 1), grid.row(y)});
+    }
+    return count;
+};
+
+// Counts matches one row at a time, keeping the masks for only the last four
+// rows, which is as far as either pattern reaches.
+struct row_window {
+    constexpr explicit row_window(i64 width)
+        : width_(width), masks_(4 * 4 * words_per_row(width))
+    {}
+
+    // Returns the number of matches for each part whose lowest row is the one
+    // just added, or nullopt (adding nothing) if the row is the wrong width.
+    // The width is checked in release builds too, as the rows come from an
+    // untrusted stream and a longer one would overrun its slot.
+    constexpr auto push(std::string_view row)
+        -> std::optional<std::pair<i64, i64>>
+    {
+        if (i64(row.size()) != width_) {
+            return std::nullopt;
+        }
+        fill_row_masks(row, slot(n_rows_));
+        ++n_rows_;
+
+        std::pair<i64, i64> found{count_horizontal(recent(0)), 0};
+        if (n_rows_ >= 3) {
+            found.second = count_crosses({recent(2), recent(1), recent(0)});
+        }
+        if (n_rows_ >= 4) {
+            found.first += count_spanning(
+                {recent(3), recent(2), recent(1), recent(0)});
+        }
+        return found;
+    }
+
+private:
+    i64 width_;
+    i64 n_rows_ = 0;
+    std::vector<u64> masks_;
+
+    constexpr auto slot(i64 row) -> std::span<u64>
+    {
+        std::size_t const stride = masks_.size() / 4;
+        return std::span(masks_).subspan((row % 4) * stride, stride);
+    }
+
+    // Returns the masks for the row age rows before the newest
+    constexpr auto recent(i64 age) -> row_masks
+    {
+        return split_row_masks(slot(n_rows_ - 1 - age));
+    }
+};
+
+// Reads the grid a line at a time, so that memory use depends only on its
+// width. Returns nullopt if the lines are not all the same width.
+auto const solve_stream
+    = [](std::istream& in) -> std::optional<std::pair<i64, i64>> {
+    std::string line;
+    std::optional<row_window> window;
+    std::pair<i64, i64> total{0, 0};
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        if (!window) {
+            window.emplace(line.size());
+        }
+        auto const found = window->push(line);
+        if (!found) {
+            return std::nullopt;
+        }
+        total.first += found->first;
+        total.second += found->second;
+    }
+    return total;
+};
+
+// Counts the occurrences of a dictionary of words in all eight directions of a
+// grid, using an Aho-Corasick automaton so that each line of the grid is read
+// once however many words there are. An occurrence is a starting cell and a
+// direction, so a palindrome is found twice: once each way.
+struct word_search {
+    constexpr explicit word_search(std::span<std::string_view const> words)
+    {
+        // Map each byte used by the dictionary to a symbol, with 0 for the
+        // bytes which can never be part of a match
+        for (std::string_view word : words) {
+            for (char c : word) {
+                auto& sym = symbols_[static_cast<unsigned char>(c)];
+                if (sym == 0) {
+                    sym = ++n_symbols_;
+                }
+            }
+        }
+        ++n_symbols_;
+
+        // Build the trie. Node 0 is the root, so it can't be a child and a
+        // zero transition means there isn't one yet.
+        add_node();
+        for (std::string_view word : words) {
+            assert(!word.empty());
+            std::uint32_t node = 0;
+            for (char c : word) {
+                if (transition(node, c) == 0) {
+                    // Adding a node may reallocate the transitions
+                    std::uint32_t const child = add_node();
+                    transition(node, c) = child;
+                }
+                node = transition(node, c);
+            }
+            word_nodes_.push_back(node);
+        }
+
+        // Fill in the failure links breadth first, and complete the
+        // transitions so that following one never needs to backtrack
+        order_.push_back(0);
+        for (std::size_t i = 0; i < order_.size(); i++) {
+            std::uint32_t const node = order_[i];
+            for (std::uint32_t sym = 0; sym < n_symbols_; sym++) {
+                auto& next = transitions_[node * n_symbols_ + sym];
+                std::uint32_t const fallback
+                    = node == 0 ? 0
+                                : transitions_[fail_[node] * n_symbols_ + sym];
+                if (next == 0) {
+                    next = fallback;
+                } else {
+                    fail_[next] = fallback;
+                    order_.push_back(next);
+                }
+            }
+        }
+    }
+
+    // Returns the number of occurrences of each of the words, in the order
+    // they were given
+    constexpr auto count(grid2d const& grid) const -> std::vector<i64>
+    {
+        std::vector<i64> visits(fail_.size());
+        for (int dx : {-1, 0, 1}) {
+            for (int dy : {-1, 0, 1}) {
+                if (dx != 0 || dy != 0) {
+                    count_direction(grid, dx, dy, visits);
+                }
+            }
+        }
+
+        // Every word which ends at a node also ends wherever that node's
+        // failure link points, so pass the visits back down the links,
+        // deepest nodes first
+        for (std::uint32_t node : order_ | std::views::drop(1)
+                 | std::views::reverse) {
+            visits[fail_[node]] += visits[node];
+        }
+
+        std::vector<i64> counts;
+        for (std::uint32_t node : word_nodes_) {
+            counts.push_back(visits[node]);
+        }
+        return counts;
+    }
+
+private:
+    std::array<std::uint32_t, 256> symbols_{};
+    std::uint32_t n_symbols_ = 0;
+    std::vector<std::uint32_t> transitions_;
+    std::vector<std::uint32_t> fail_;
+    std::vector<std::uint32_t> order_; // Nodes in breadth-first order
+    std::vector<std::uint32_t> word_nodes_;
+
+    constexpr auto add_node() -> std::uint32_t
+    {
+        transitions_.resize(transitions_.size() + n_symbols_);
+        fail_.push_back(0);
+        return fail_.size() - 1;
+    }
+
+    constexpr auto transition(std::uint32_t node, char c) -> std::uint32_t&
+    {
+        return transitions_[node * n_symbols_
+                            + symbols_[static_cast<unsigned char>(c)]];
+    }
+
+    // Runs the automaton along every line of the grid in direction (dx, dy),
+    // each starting from a cell whose predecessor is off the grid
+    constexpr void count_direction(grid2d const& grid, int dx, int dy,
+                                   std::vector<i64>& visits) const
+    {
+        auto in_bounds = [&](i64 x, i64 y) {
+            return x >= 0 && x < grid.width && y >= 0 && y < grid.height;
+        };
+
+        for (i64 y = 0; y < grid.height; y++) {
+            for (i64 x = 0; x < grid.width; x++) {
+                if (in_bounds(x - dx, y - dy)) {
+                    continue;
+                }
+                std::uint32_t node = 0;
+                for (i64 i = x, j = y; in_bounds(i, j); i += dx, j += dy) {
+                    node = transitions_[node * n_symbols_
+                                        + symbols_[static_cast<unsigned char>(
+                                            grid.data[j * grid.width + i])]];
+                    ++visits[node];
+                }
+            }
+        }
+    }
 };
 
 constexpr auto& test_data =
@@ -74,8 +375,31 @@ MAMMMXMMMM
 MXMXAXMASX
 )";
 
-static_assert(part1(parse_input(test_data)) == 18);
-static_assert(part2(parse_input(test_data)) == 9);
+static_assert(part1(make_bit_grid(parse_input(test_data))) == 18);
+static_assert(part2(make_bit_grid(parse_input(test_data))) == 9);
+
+static_assert([] {
+    auto const grid = parse_input(test_data);
+    row_window window(grid.width);
+    std::pair<i64, i64> total{0, 0};
+    for (i64 y = 0; y < grid.height; y++) {
+        auto const [p1, p2] = window.push(grid.row(y)).value();
+        total.first += p1;
+        total.second += p2;
+    }
+    return total == std::pair<i64, i64>(18, 9);
+}());
+
+static_assert([] {
+    row_window window(4);
+    return window.push("XMAS") && !window.push("XMASX") && !window.push("XM");
+}());
+
+static_assert([] {
+    constexpr std::array<std::string_view, 3> words{"XMAS", "SAMX", "MAS"};
+    auto const counts = word_search(words).count(parse_input(test_data));
+    return counts[0] == 18 && counts[1] == 18 && counts[2] == 38;
+}());
 
 } // namespace
 
@@ -86,7 +410,31 @@ int main(int argc, char** argv)
         return -1;
     }
 
-    grid2d const grid = parse_input(aoc::string_from_file(argv[1]));
+    if (aoc::has_flag(argc, argv, "--stream")) {
+        std::ifstream file(argv[1]);
+        auto const totals = solve_stream(file);
+        if (!totals) {
+            std::println(stderr, "The lines of the grid differ in width");
+            return -1;
+        }
+        std::println("Part 1: {}", totals->first);
+        std::println("Part 2: {}", totals->second);
+        return 0;
+    }
+
+    if (auto const list = aoc::get_option(argc, argv, "--words")) {
+        auto const words = flux::split_string(*list, ',')
+                               .to<std::vector<std::string_view>>();
+        auto const counts = word_search(words).count(
+            parse_input(aoc::string_from_file(argv[1])));
+        for (std::size_t i = 0; i < words.size(); i++) {
+            std::println("{}: {}", words[i], counts[i]);
+        }
+        return 0;
+    }
+
+    auto const grid
+        = make_bit_grid(parse_input(aoc::string_from_file(argv[1])));
 
     std::println("Part 1: {}", part1(grid));
     std::println("Part 2: {}", part2(grid));
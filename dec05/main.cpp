@@ -1,31 +1,60 @@
 
 #include <aoc.hpp>
 
-#include <ankerl/unordered_dense.h>
+#include <bitset>
+#include <sstream>
+#include <stdexcept>
 
 namespace {
 
-using rules_t = ankerl::unordered_dense::set<std::pair<int, int>>;
+// Page numbers are all two digits
+constexpr int max_pages = 100;
+
+using page_set = std::bitset<max_pages>;
+
+// The ordering rules as bit matrices: the rule "l|r" sets bit r of after[l]
+// and bit l of before[r]
+struct rules_t {
+    std::array<page_set, max_pages> after;
+    std::array<page_set, max_pages> before;
+
+    void add(int l, int r)
+    {
+        assert(l >= 0 && l < max_pages && r >= 0 && r < max_pages);
+        after[l].set(r);
+        before[r].set(l);
+    }
+
+    auto contains(int l, int r) const -> bool { return after[l].test(r); }
+};
 
 using update_t = std::vector<int>;
 
+// Parses a page number, rejecting any which would index outside the rule
+// matrices. This is checked in release builds too, as the input is untrusted.
+auto const parse_page = [](std::string_view str) -> int {
+    int const page = aoc::parse<int>(str);
+    if (page < 0 || page >= max_pages) {
+        throw std::out_of_range("Page out of range: " + std::string(str));
+    }
+    return page;
+};
+
 auto const parse_rules = [](std::string_view input) -> rules_t {
-    return flux::split_string(input, '\n')
-        .map([](std::string_view line) {
-            auto bar = line.find('|');
-            return std::pair(aoc::parse<int>(line.substr(0, bar)),
-                             aoc::parse<int>(line.substr(bar + 1)));
-        })
-        .to<rules_t>();
+    rules_t rules;
+    flux::split_string(input, '\n').for_each([&](std::string_view line) {
+        auto bar = line.find('|');
+        rules.add(parse_page(line.substr(0, bar)),
+                  parse_page(line.substr(bar + 1)));
+    });
+    return rules;
 };
 
 auto const parse_updates = [](std::string_view input) -> std::vector<update_t> {
     return flux::split_string(input, '\n')
         .filter([](std::string_view line) { return !line.empty(); })
         .map([](std::string_view line) {
-            return flux::split_string(line, ',')
-                .map(aoc::parse<int>)
-                .to<update_t>();
+            return flux::split_string(line, ',').map(parse_page).to<update_t>();
         })
         .to<std::vector>();
 };
@@ -37,30 +66,124 @@ auto const parse_input
                      parse_updates(input.substr(blank + 2)));
 };
 
+// An update is in order if no page must come before any page we've already
+// seen
+auto const is_ordered = [](rules_t const& rules, update_t const& u) -> bool {
+    page_set seen;
+    for (int page : u) {
+        if ((rules.after[page] & seen).any()) {
+            return false;
+        }
+        seen.set(page);
+    }
+    return true;
+};
+
+// Returns the page which would be in the middle once the update is sorted,
+// which is the one with exactly half of the other pages before it, or nullopt
+// if the rules don't say
+auto const sorted_middle
+    = [](rules_t const& rules, update_t const& u) -> std::optional<int> {
+    page_set pages;
+    for (int page : u) {
+        pages.set(page);
+    }
+    for (int page : u) {
+        if ((rules.before[page] & pages).count() == u.size() / 2) {
+            return page;
+        }
+    }
+    return std::nullopt;
+};
+
 auto const part1
     = [](rules_t const& rules, std::vector<update_t> const& updates) -> int {
     return flux::ref(updates)
-        .filter([&rules](update_t const& u) {
-            return std::ranges::is_sorted(
-                u, [&rules](int l, int r) { return rules.contains({l, r}); });
-        })
+        .filter([&rules](update_t const& u) { return is_ordered(rules, u); })
         .map([](update_t const& u) { return u.at(u.size() / 2); })
         .sum();
 };
 
 auto const part2
     = [](rules_t const& rules, std::vector<update_t> const& updates) -> int {
-    auto cmp = [&](int l, int r) { return rules.contains({l, r}); };
     return flux::ref(updates)
-        .filter(
-            [&](update_t const& u) { return !std::ranges::is_sorted(u, cmp); })
-        .map([&](update_t u) {
-            std::ranges::nth_element(u, u.begin() + u.size() / 2, cmp);
-            return u.at(u.size() / 2);
+        .filter([&rules](update_t const& u) { return !is_ordered(rules, u); })
+        .map([&rules](update_t const& u) {
+            return sorted_middle(rules, u).value();
         })
         .sum();
 };
 
+// Answers queries about updates while rules are still arriving. Alongside the
+// rules themselves we maintain their transitive closure, so that we can report
+// when a new rule makes them cyclic. Such a rule is still accepted: the rules
+// in the puzzle input are cyclic as a whole, and only need to be consistent
+// among the pages of each update, so queries use the direct rules alone.
+struct rule_service {
+    // Adds the rule "l|r", returning true if it closes a cycle
+    auto add_rule(int l, int r) -> bool
+    {
+        rules_.add(l, r);
+        bool const cycle = l == r || reach_[r].test(l);
+        page_set via = reach_[r];
+        via.set(r);
+        for (int page = 0; page < max_pages; page++) {
+            if (page == l || reach_[page].test(l)) {
+                reach_[page] |= via;
+            }
+        }
+        return cycle;
+    }
+
+    // Returns whether the rules so far imply that from comes before to
+    auto reaches(int from, int to) const -> bool
+    {
+        return reach_[from].test(to);
+    }
+
+    auto rules() const -> rules_t const& { return rules_; }
+
+private:
+    rules_t rules_;
+    std::array<page_set, max_pages> reach_;
+};
+
+struct online_totals {
+    int ordered = 0;   // Sum of the middle pages of ordered updates
+    int corrected = 0; // Sum of the sorted middle pages of the others
+    int cycles = 0;    // Number of rules which closed a cycle
+    int unsorted = 0;  // Number of updates which the rules didn't fully order
+};
+
+// Reads rules and updates in any order, answering each update using the rules
+// which came before it. Unlike part2, an update which those rules don't fully
+// order is expected here, as later rules may be needed to order it, so it is
+// counted rather than treated as an error.
+auto const run_online = [](std::istream& in) -> online_totals {
+    rule_service service;
+    online_totals totals;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string_view const str = line;
+        if (auto bar = str.find('|'); bar != str.npos) {
+            int const l = parse_page(str.substr(0, bar));
+            int const r = parse_page(str.substr(bar + 1));
+            totals.cycles += service.add_rule(l, r);
+        } else if (!str.empty()) {
+            auto const u
+                = flux::split_string(str, ',').map(parse_page).to<update_t>();
+            if (is_ordered(service.rules(), u)) {
+                totals.ordered += u.at(u.size() / 2);
+            } else if (auto middle = sorted_middle(service.rules(), u)) {
+                totals.corrected += *middle;
+            } else {
+                ++totals.unsorted;
+            }
+        }
+    }
+    return totals;
+};
+
 constexpr auto& test_input =
     R"(47|53
 97|13
@@ -101,6 +224,38 @@ int main(int argc, char** argv)
         auto [rules, updates] = parse_input(test_input);
         assert(part1(rules, updates) == 143);
         assert(part2(rules, updates) == 123);
+
+        std::istringstream in(test_input);
+        auto const totals = run_online(in);
+        assert(totals.ordered == 143 && totals.corrected == 123);
+        assert(totals.cycles == 0 && totals.unsorted == 0);
+
+        // An update which the rules so far don't fully order is counted
+        std::istringstream partial("61|13\n13,61,29,47,75\n");
+        assert(run_online(partial).unsorted == 1);
+
+        rule_service service;
+        assert(!service.add_rule(97, 47) && !service.add_rule(47, 13));
+        assert(service.reaches(97, 13) && !service.reaches(13, 97));
+        assert(service.add_rule(13, 97));
+
+        // Pages which don't fit the rule matrices are rejected
+        [[maybe_unused]] bool rejected = false;
+        try {
+            parse_input("47|100\n\n47,100\n");
+        } catch (std::out_of_range const&) {
+            rejected = true;
+        }
+        assert(rejected);
+
+        rejected = false;
+        try {
+            std::istringstream bad("47|-1\n");
+            run_online(bad);
+        } catch (std::out_of_range const&) {
+            rejected = true;
+        }
+        assert(rejected);
     }
 
     if (argc < 2) {
@@ -108,8 +263,24 @@ int main(int argc, char** argv)
         return -1;
     }
 
-    auto [rules, updates] = parse_input(aoc::string_from_file(argv[1]));
+    try {
+        if (aoc::has_flag(argc, argv, "--online")) {
+            std::ifstream file(argv[1]);
+            auto const totals = run_online(file);
+            std::println("Part 1: {}", totals.ordered);
+            std::println("Part 2: {}", totals.corrected);
+            std::println("Rules closing a cycle: {}", totals.cycles);
+            std::println("Updates the rules didn't order: {}",
+                         totals.unsorted);
+            return 0;
+        }
+
+        auto [rules, updates] = parse_input(aoc::string_from_file(argv[1]));
 
-    std::println("Part 1: {}", part1(rules, updates));
-    std::println("Part 2: {}", part2(rules, updates));
+        std::println("Part 1: {}", part1(rules, updates));
+        std::println("Part 2: {}", part2(rules, updates));
+    } catch (std::out_of_range const& e) {
+        std::println(stderr, "{}", e.what());
+        return -1;
+    }
 }
\ No newline at end of file
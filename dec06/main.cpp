@@ -32,6 +32,30 @@ struct position {
     }
 };
 
+// Returns how many steps in direction d it takes to get from p to q, or zero
+// if q isn't ahead of p in that direction
+constexpr auto steps_to(position p, position q, direction d) -> i64
+{
+    using enum direction;
+    switch (d) {
+    case north: return q.x == p.x ? std::max<i64>(p.y - q.y, 0) : 0;
+    case east: return q.y == p.y ? std::max<i64>(q.x - p.x, 0) : 0;
+    case south: return q.x == p.x ? std::max<i64>(q.y - p.y, 0) : 0;
+    case west: return q.y == p.y ? std::max<i64>(p.x - q.x, 0) : 0;
+    }
+}
+
+constexpr auto walk(position p, direction d, i64 steps) -> position
+{
+    using enum direction;
+    switch (d) {
+    case north: return {p.x, p.y - steps};
+    case east: return {p.x + steps, p.y};
+    case south: return {p.x, p.y + steps};
+    case west: return {p.x - steps, p.y};
+    }
+}
+
 struct grid2d {
     std::string data;
     i64 width;
@@ -56,7 +80,7 @@ struct grid2d {
 
     constexpr auto to_position(index_type idx) const -> position
     {
-        return {idx % height, idx / width};
+        return {idx % width, idx / width};
     }
 };
 
@@ -69,9 +93,20 @@ auto parse_input = [](std::string_view input) -> grid2d {
 
 using guard_state = std::array<bool, 4>;
 
+// The state of the guard just before it first steps into a cell
+struct entry {
+    position cell;
+    position from;
+    direction dir;
+};
+
+// Walks the guard from pos until it leaves the grid, and returns how it first
+// entered each of the cells it visits after the start, or nullopt if it walks
+// in a loop
 auto walk_grid = [](grid2d const& grid,
-                    position pos) -> std::optional<std::vector<guard_state>> {
+                    position pos) -> std::optional<std::vector<entry>> {
     std::vector<guard_state> states(grid.data.size());
+    std::vector<entry> entries;
     direction dir = direction::north;
 
     while (true) {
@@ -83,17 +118,131 @@ auto walk_grid = [](grid2d const& grid,
         }
 
         auto next_pos = pos + dir;
+        while (grid.is_in_bounds(next_pos) && grid[next_pos] == '#') {
+            ++dir;
+            next_pos = pos + dir;
+        }
         if (!grid.is_in_bounds(next_pos)) {
             break;
         }
-        while (grid[next_pos] == '#') {
-            ++dir;
-            next_pos = pos + dir;
+        if (!flux::any(states.at(grid.to_index(next_pos)), flux::pred::id)) {
+            entries.push_back({.cell = next_pos, .from = pos, .dir = dir});
         }
         pos = next_pos;
     }
 
-    return states;
+    return entries;
+};
+
+// Where the guard ends up after walking in a straight line: either the cell
+// before an obstacle, where it turns, or the last cell before it leaves
+struct jump {
+    position last;
+    bool leaves = false;
+};
+
+// For every cell and direction, where the guard stops if it walks that way
+// from there, so that a walk costs one lookup per turn rather than one per
+// step
+struct jump_table {
+    constexpr explicit jump_table(grid2d const& grid)
+        : width_(grid.width), size_(grid.data.size())
+    {
+        for (int d = 0; d < 4; d++) {
+            auto& table = jumps_[d];
+            table.resize(grid.data.size());
+            // Fill in the cell ahead of each cell before the cell itself,
+            // so that we can carry on from where it stops
+            bool const forwards = direction{d} == direction::north
+                || direction{d} == direction::west;
+            for (i64 n = 0; n < i64(table.size()); n++) {
+                i64 const idx = forwards ? n : i64(table.size()) - 1 - n;
+                position const pos = grid.to_position(idx);
+                position const ahead = pos + direction{d};
+                if (!grid.is_in_bounds(ahead)) {
+                    table[idx] = {.last = pos, .leaves = true};
+                } else if (grid[ahead] == '#') {
+                    table[idx] = {.last = pos};
+                } else {
+                    table[idx] = table[grid.to_index(ahead)];
+                }
+            }
+        }
+    }
+
+    constexpr auto size() const -> i64 { return size_; }
+
+    constexpr auto to_index(position p) const -> i64
+    {
+        return p.y * width_ + p.x;
+    }
+
+    // Returns where the guard stops when walking from pos in direction dir,
+    // if there were also an obstacle at block
+    constexpr auto next(position pos, direction dir, position block) const
+        -> jump
+    {
+        jump const j = jumps_[int(dir)][to_index(pos)];
+        i64 const until_block = steps_to(pos, block, dir);
+        if (until_block > 0 && until_block <= steps_to(pos, j.last, dir)) {
+            return {.last = walk(pos, dir, until_block - 1)};
+        }
+        return j;
+    }
+
+private:
+    i64 width_;
+    i64 size_;
+    std::array<std::vector<jump>, 4> jumps_;
+};
+
+// Records the turns the guard makes during a walk. Rather than clearing it
+// between walks we move on to a new generation, and a turn only counts as
+// recorded if it was stamped with the current one.
+struct turn_log {
+    constexpr explicit turn_log(i64 n_cells) : stamps_(4 * n_cells) {}
+
+    constexpr void reset()
+    {
+        if (++generation_ == 0) {
+            std::ranges::fill(stamps_, 0);
+            generation_ = 1;
+        }
+    }
+
+    // Records a turn, returning false if it was already made in this walk
+    constexpr auto insert(i64 cell, direction dir) -> bool
+    {
+        auto& stamp = stamps_[4 * cell + int(dir)];
+        if (stamp == generation_) {
+            return false;
+        }
+        stamp = generation_;
+        return true;
+    }
+
+private:
+    std::vector<std::uint32_t> stamps_;
+    std::uint32_t generation_ = 1;
+};
+
+// Returns whether the guard walks in a loop with an extra obstacle at block.
+// Only the states in which the guard turns need recording, as a loop must
+// repeat one of those.
+auto const is_loop = [](jump_table const& jumps, position pos, direction dir,
+                        position block, turn_log& turns) -> bool {
+    turns.reset();
+    while (true) {
+        jump const j = jumps.next(pos, dir, block);
+        if (j.leaves) {
+            return false;
+        }
+        if (!turns.insert(jumps.to_index(j.last), dir)) {
+            return true;
+        }
+        pos = j.last;
+        ++dir;
+    }
 };
 
 auto find_start = [](grid2d const& grid) -> position {
@@ -102,26 +251,30 @@ auto find_start = [](grid2d const& grid) -> position {
 };
 
 auto part1 = [](grid2d const& grid) -> i64 {
-    return flux::from(walk_grid(grid, find_start(grid)).value())
-        .count_if(std::bind_back(flux::any, flux::pred::id));
+    return walk_grid(grid, find_start(grid)).value().size() + 1;
 };
 
+// An obstacle only changes the guard's route from the moment it would first
+// have stepped into the obstacle's cell, so each walk resumes from there. The
+// candidates are shared out between threads, each with its own turn log.
 auto part2 = [](grid2d const& grid) -> i64 {
-    auto const start_pos = find_start(grid);
-
-    return flux::zip(walk_grid(grid, start_pos).value(), flux::ints())
-        .filter([](auto pair) { return flux::any(pair.first, flux::pred::id); })
-        .map([&grid](auto pair) { return grid.to_position(pair.second); })
-        .count_if([&](position pos) {
-            if (pos == start_pos) {
-                return false;
-            }
+    jump_table const jumps(grid);
+    auto const entries = walk_grid(grid, find_start(grid)).value();
 
-            grid2d copy = grid;
-            copy[pos] = '#';
-
-            return !walk_grid(copy, start_pos).has_value();
+    auto count_loops = [&jumps](std::span<entry const> chunk) -> i64 {
+        turn_log turns(jumps.size());
+        return flux::ref(chunk).count_if([&](entry const& e) {
+            return is_loop(jumps, e.from, e.dir, e.cell, turns);
         });
+    };
+
+    if consteval {
+        return count_loops(entries);
+    } else {
+        auto const chunks
+            = aoc::split_span(std::span(entries), aoc::thread_count());
+        return flux::sum(aoc::parallel_map(chunks, count_loops));
+    }
 };
 
 constexpr auto& test_input =
@@ -146,6 +299,10 @@ static_assert([] {
 
 int main(int argc, char** argv)
 {
+    // The static_assert above only covers the serial path which part2 takes
+    // at compile time, so check the parallel one too
+    assert(part2(parse_input(test_input)) == 6);
+
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
@@ -20,47 +20,51 @@ auto parse_input = [](std::string_view input) -> std::vector<equation> {
         .to<std::vector>();
 };
 
-auto const concat = [](i64 a, i64 b) -> i64 {
-    auto tmp = b;
-    while (tmp > 0) {
-        a *= 10;
-        tmp /= 10;
+// Returns the smallest power of ten greater than n, which is what a number
+// must be multiplied by before n can be concatenated onto it. Zero has one
+// digit like any other, so x || 0 is 10 * x.
+auto const next_pow10 = [](i64 n) -> i64 {
+    i64 pow = 10;
+    while (pow <= n) {
+        pow *= 10;
     }
-    return a + b;
+    return pow;
 };
 
+// Works backwards from the target, undoing the operator before each operand
+// starting from the last. Multiplication can only be undone if the operand
+// divides what's left, concatenation if what's left ends with the operand's
+// digits, and addition if what's left is at least the operand, so most
+// branches are cut off straight away.
 template <bool Part2>
 auto const is_valid = [](equation const& eq) -> bool {
     auto const& [target, args] = eq;
 
-    std::vector<std::pair<i64, std::size_t>> stack;
-    stack.push_back({args.at(0), 1});
-
-    while (!stack.empty()) {
-        auto [so_far, idx] = stack.back();
-        stack.pop_back();
-        if (so_far > target) {
-            continue;
+    // Returns whether the first n operands can make remaining
+    auto solve = [&args](this auto const& self, i64 remaining,
+                         std::size_t n) -> bool {
+        i64 const val = args.at(n - 1);
+        if (n == 1) {
+            return remaining == val;
         }
-
-        i64 val = args.at(idx);
-        if (idx == args.size() - 1) {
-            bool valid = (so_far + val == target) || (so_far * val == target);
-            if constexpr (Part2) {
-                valid |= (concat(so_far, val) == target);
-            }
-            if (valid) {
+        if (val == 0) {
+            // Multiplying by zero wipes out whatever the other operands make
+            if (remaining == 0) {
                 return true;
             }
-        } else {
-            stack.push_back({so_far + val, idx + 1});
-            stack.push_back({so_far * val, idx + 1});
-            if constexpr (Part2) {
-                stack.push_back({concat(so_far, val), idx + 1});
+        } else if (remaining % val == 0 && self(remaining / val, n - 1)) {
+            return true;
+        }
+        if constexpr (Part2) {
+            i64 const pow = next_pow10(val);
+            if (remaining % pow == val && self(remaining / pow, n - 1)) {
+                return true;
             }
         }
-    }
-    return false;
+        return remaining >= val && self(remaining - val, n - 1);
+    };
+
+    return solve(target, args.size());
 };
 
 template <bool Part2>
@@ -71,6 +75,20 @@ auto calculate = [](std::vector<equation> const& eqs) -> i64 {
 auto part1 = calculate<false>;
 auto part2 = calculate<true>;
 
+// Parses and solves each block of lines on a separate thread
+auto const solve_parallel = [](std::string_view input) -> std::pair<i64, i64> {
+    return aoc::parallel_fold_lines(
+        input,
+        [](std::string_view chunk) {
+            auto const equations = parse_input(chunk);
+            return std::pair(part1(equations), part2(equations));
+        },
+        std::pair<i64, i64>(0, 0),
+        [](std::pair<i64, i64> sum, std::pair<i64, i64> next) {
+            return std::pair(sum.first + next.first, sum.second + next.second);
+        });
+};
+
 constexpr auto& test_input =
     R"(190: 10 19
 3267: 81 40 27
@@ -88,17 +106,27 @@ static_assert([] {
     return part1(equations) == 3749 && part2(equations) == 11387;
 }());
 
+// Zero operands
+static_assert(is_valid<false>(equation{7, {3, 0, 7}}));
+static_assert(is_valid<false>(equation{0, {5, 0}}));
+static_assert(is_valid<false>(equation{3, {3, 0}}));
+static_assert(!is_valid<false>(equation{30, {3, 0}}));
+static_assert(is_valid<true>(equation{30, {3, 0}}));
+static_assert(is_valid<true>(equation{307, {3, 0, 7}}));
+
 } // namespace
 
 int main(int argc, char** argv)
 {
+    assert((solve_parallel(test_input) == std::pair<i64, i64>(3749, 11387)));
+
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
     }
 
-    auto const equations = parse_input(aoc::string_from_file(argv[1]));
+    auto const [p1, p2] = solve_parallel(aoc::string_from_file(argv[1]));
 
-    std::println("Part 1: {}", part1(equations));
-    std::println("Part 2: {}", part2(equations));
+    std::println("Part 1: {}", p1);
+    std::println("Part 2: {}", p2);
 }
\ No newline at end of file
@@ -14,34 +14,32 @@ struct position {
         = default;
 };
 
+// The cells are stored according to Layout (see aoc::layout)
+template <typename Layout = aoc::layout::row_major>
 struct grid2d {
-    std::string data;
-    int width;
-    int height;
+    aoc::grid<char, Layout> cells;
 
     constexpr auto is_in_bounds(position p) const -> bool
     {
-        return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height;
+        return cells.is_in_bounds({p.x, p.y});
     }
 
     constexpr auto operator[](position p) const -> char
     {
-        return data.at(p.y * width + p.x);
+        return cells[{p.x, p.y}];
     }
 
     constexpr auto positions() const -> flux::random_access_sequence auto
     {
         return flux::cartesian_product_map(
-            [](int j, int i) { return position{i, j}; }, flux::iota(0, height),
-            flux::iota(0, width));
+            [](int j, int i) { return position{i, j}; },
+            flux::iota(0, cells.height), flux::iota(0, cells.width));
     }
 };
 
-auto const parse_input = [](std::string_view input) -> grid2d {
-    return grid2d{
-        .data = flux::filter(input, flux::pred::neq('\n')).to<std::string>(),
-        .width = int(flux::find(input, '\n')),
-        .height = int(flux::count_eq(input, '\n'))};
+template <typename Layout = aoc::layout::row_major>
+auto const parse_input = [](std::string_view input) -> grid2d<Layout> {
+    return {aoc::parse_grid<Layout>(input)};
 };
 
 auto const get_neighbours = [](position p) {
@@ -55,9 +53,9 @@ struct trail_info {
     int rating;
 };
 
-auto const walk_trail = [](grid2d const& grid, position start) -> trail_info {
+auto const walk_trail = [](auto const& grid, position start) -> trail_info {
     std::vector<position> goals;
-    goals.reserve(grid.data.size() / 10);
+    goals.reserve(grid.cells.data.size() / 10);
 
     [&](this auto const& self, position here) -> void {
         char value = grid[here];
@@ -78,8 +76,9 @@ auto const walk_trail = [](grid2d const& grid, position start) -> trail_info {
     return {.score = score, .rating = int(goals.size())};
 };
 
-auto const walk_all = [](std::string_view input) -> trail_info {
-    auto grid = parse_input(input);
+template <typename Layout>
+auto const walk_all_in = [](std::string_view input) -> trail_info {
+    auto grid = parse_input<Layout>(input);
     return grid.positions()
         .filter([&](auto pos) { return grid[pos] == '0'; })
         .map(std::bind_front(walk_trail, grid))
@@ -92,6 +91,8 @@ auto const walk_all = [](std::string_view input) -> trail_info {
             trail_info{});
 };
 
+auto const walk_all = walk_all_in<aoc::layout::row_major>;
+
 /*
  * Part 1 tests (lots of them today)
  */
@@ -181,6 +182,14 @@ static_assert(walk_all(test_input8).rating == 227);
 constexpr auto& test_input9 = test_input5;
 static_assert(walk_all(test_input9).rating == 81);
 
+// The answers don't depend on how the grid is stored
+static_assert([] {
+    auto const tiled = walk_all_in<aoc::layout::tiled<4>>(test_input5);
+    auto const morton = walk_all_in<aoc::layout::morton>(test_input5);
+    return tiled.score == 36 && tiled.rating == 81 && morton.score == 36
+        && morton.rating == 81;
+}());
+
 } // namespace
 
 int main(int argc, char** argv)
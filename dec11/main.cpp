@@ -42,26 +42,62 @@ auto const split_digits = [](u64 n) -> std::optional<std::pair<u64, u64>> {
     return std::pair{first, n - (first * k)};
 };
 
+// Each distinct stone value is interned once, and the ids of the stones that
+// it turns into are memoised, so that a blink only touches flat arrays
+using stone_id = aoc::memo_id;
+using memo_t = aoc::memo<u64, std::array<stone_id, 2>>;
+
+constexpr auto no_stone = stone_id(-1);
+
+auto const change_stone = [](memo_t& memo, u64 val) -> std::array<stone_id, 2> {
+    if (val == 0) {
+        return {memo.intern(1), no_stone};
+    } else if (auto opt = split_digits(val)) {
+        return {memo.intern(opt->first), memo.intern(opt->second)};
+    } else {
+        return {memo.intern(val * 2024), no_stone};
+    }
+};
+
 template <int N>
-auto blink = [](stones_map stones) -> u64 {
-    stones_map next;
+auto blink = [](stones_map const& stones) -> u64 {
+    memo_t memo;
+    std::vector<u64> counts;
+    for (auto [val, count] : stones) {
+        auto const id = memo.intern(val);
+        counts.resize(memo.size());
+        counts[std::to_underlying(id)] += count;
+    }
+
+    std::vector<u64> next;
 
     for (auto _ : flux::ints(0, N)) {
-        for (auto [val, count] : stones) {
-            if (val == 0) {
-                next[1] += count;
-            } else if (auto opt = split_digits(val)) {
-                next[opt->first] += count;
-                next[opt->second] += count;
+        next.assign(counts.size(), 0);
+        for (std::uint32_t idx = 0; idx < counts.size(); ++idx) {
+            if (counts[idx] == 0) {
+                continue;
+            }
+
+            auto const id = stone_id(idx);
+            std::array<stone_id, 2> children;
+            if (auto const* cached = memo.find(id)) {
+                children = *cached;
             } else {
-                next[val * 2024] += count;
+                children = change_stone(memo, memo.key(id));
+                memo.insert(id, children);
+            }
+
+            next.resize(memo.size());
+            for (stone_id child : children) {
+                if (child != no_stone) {
+                    next[std::to_underlying(child)] += counts[idx];
+                }
             }
         }
-        std::swap(stones, next);
-        next.clear();
+        std::swap(counts, next);
     }
 
-    return flux::sum(stones | std::views::values);
+    return flux::sum(counts);
 };
 
 auto const part1 = blink<25>;
@@ -77,6 +113,26 @@ int main(int argc, char** argv)
         assert(part1(parse_input(test_input)) == 55312);
     }
 
+    {
+        // A bounded table evicts the least recently used value, but the key
+        // keeps its id and the value can be stored again. With integer keys,
+        // the typed ids keep find(key) and find(id) apart.
+        aoc::memo<std::uint32_t, u64, 2> memo;
+        memo.insert(100, 1);
+        memo.insert(200, 2);
+        memo.insert(300, 3);
+        assert(memo.find(100) == nullptr);
+        assert(memo.find(200) != nullptr && *memo.find(200) == 2);
+        assert(memo.find(300) != nullptr && *memo.find(300) == 3);
+
+        memo.insert(100, 4);
+        auto const id = memo.intern(100);
+        assert(std::to_underlying(id) == 0 && memo.size() == 3);
+        assert(memo.find(id) != nullptr && *memo.find(id) == 4);
+        assert(memo.find(200) == nullptr);
+        assert(memo.find(300) != nullptr && *memo.find(300) == 3);
+    }
+
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
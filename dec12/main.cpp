@@ -5,33 +5,31 @@ namespace {
 
 using vec2 = aoc::vec2_t<int>;
 
+// The cells are stored according to Layout (see aoc::layout)
+template <typename Layout = aoc::layout::row_major>
 struct grid2d {
-    std::string data;
-    int width;
-    int height;
+    aoc::grid<char, Layout> cells;
 
     constexpr auto operator[](vec2 const& p) const -> char
     {
-        if (p.x < 0 || p.x >= width || p.y < 0 || p.y >= height) {
+        if (!cells.is_in_bounds(p)) {
             return '.';
         } else {
-            return data.at(p.y * width + p.x);
+            return cells[p];
         }
     }
 
     constexpr auto positions() const -> flux::random_access_sequence auto
     {
         return flux::cartesian_product_map(
-            [](int j, int i) { return vec2{i, j}; }, flux::iota(0, height),
-            flux::iota(0, width));
+            [](int j, int i) { return vec2{i, j}; },
+            flux::iota(0, cells.height), flux::iota(0, cells.width));
     }
 };
 
-auto const parse_input = [](std::string_view input) -> grid2d {
-    return grid2d{
-        .data = flux::filter(input, flux::pred::neq('\n')).to<std::string>(),
-        .width = int(flux::find(input, '\n')),
-        .height = int(flux::count_eq(input, '\n'))};
+template <typename Layout = aoc::layout::row_major>
+auto const parse_input = [](std::string_view input) -> grid2d<Layout> {
+    return {aoc::parse_grid<Layout>(input)};
 };
 
 constexpr auto neighbour_offsets
@@ -48,8 +46,9 @@ struct prices {
     int part2;
 };
 
-auto const calculate_prices = [](std::string_view input) -> prices {
-    grid2d grid = parse_input(input);
+template <typename Layout>
+auto const calculate_prices_in = [](std::string_view input) -> prices {
+    auto const grid = parse_input<Layout>(input);
 
     auto unassigned_positions = grid.positions().to<aoc::hash_set>();
 
@@ -103,6 +102,8 @@ auto const calculate_prices = [](std::string_view input) -> prices {
     return {p1, p2};
 };
 
+auto const calculate_prices = calculate_prices_in<aoc::layout::row_major>;
+
 [[maybe_unused]] constexpr auto& test_input1 =
     R"(AAAA
 BBCD
@@ -168,6 +169,16 @@ int main(int argc, char** argv)
         assert(calculate_prices(test_input3).part2 == 1206);
     }
 
+    // Layout tests: the answers don't depend on how the grid is stored
+    {
+        [[maybe_unused]] auto const tiled
+            = calculate_prices_in<aoc::layout::tiled<4>>(test_input3);
+        [[maybe_unused]] auto const morton
+            = calculate_prices_in<aoc::layout::morton>(test_input3);
+        assert(tiled.part1 == 1930 && tiled.part2 == 1206);
+        assert(morton.part1 == 1930 && morton.part2 == 1206);
+    }
+
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
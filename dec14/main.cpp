@@ -1,5 +1,7 @@
 
 #include <aoc.hpp>
+
+#include <cstdlib>
 #include <ctre.hpp>
 
 namespace {
@@ -24,28 +26,48 @@ auto const parse_input = [](std::string_view input) -> std::vector<robot> {
         .to<std::vector>();
 };
 
-template <vec2 Bounds>
-auto const part1 = [](std::vector<robot> robots) -> int64_t {
+// Version of the layout of our pre-parsed input cache
+constexpr std::uint32_t cache_version = 1;
+
+auto const save_cache
+    = [](std::vector<robot> const& robots, aoc::cache::writer& out) {
+    out.add(robots);
+};
+
+auto const load_cache = [](aoc::cache::reader const& in)
+    -> std::optional<std::vector<robot>> {
+    auto const robots = in.section<robot>(0);
+    if (!robots) {
+        return std::nullopt;
+    }
+    return std::vector<robot>(robots->begin(), robots->end());
+};
+
+// bounds_arg may be either a plain vec2, or a std::integral_constant holding
+// one (see aoc::dispatch), in which case the arithmetic is constant-folded
+auto const part1 = [](std::vector<robot> robots, auto bounds_arg) -> int64_t {
+    vec2 const bounds = bounds_arg;
+
     // Move robots
     for (auto& [pos, vel] : robots) {
-        pos += 100 * (vel + Bounds);
-        pos.x %= Bounds.x;
-        pos.y %= Bounds.y;
+        pos += 100 * (vel + bounds);
+        pos.x %= bounds.x;
+        pos.y %= bounds.y;
     }
 
     // Calculate safety factor
     std::array<int64_t, 4> quadrants{};
     for (auto const& [pos, _] : robots) {
-        if (pos.x < Bounds.x / 2) {
-            if (pos.y < Bounds.y / 2) {
+        if (pos.x < bounds.x / 2) {
+            if (pos.y < bounds.y / 2) {
                 ++quadrants[0];
-            } else if (pos.y > Bounds.y / 2) {
+            } else if (pos.y > bounds.y / 2) {
                 ++quadrants[1];
             }
-        } else if (pos.x > Bounds.x / 2) {
-            if (pos.y < Bounds.y / 2) {
+        } else if (pos.x > bounds.x / 2) {
+            if (pos.y < bounds.y / 2) {
                 ++quadrants[2];
-            } else if (pos.y > Bounds.y / 2) {
+            } else if (pos.y > bounds.y / 2) {
                 ++quadrants[3];
             }
         }
@@ -53,30 +75,29 @@ auto const part1 = [](std::vector<robot> robots) -> int64_t {
     return flux::product(quadrants);
 };
 
-template <vec2 Bounds>
-auto const print_robots =
-    [](int secs, std::vector<robot> const& robots, std::ofstream& where) {
-        std::vector<std::string> strings(Bounds.y, std::string(Bounds.x, '.'));
+auto const print_robots = [](int secs, std::vector<robot> const& robots,
+                             vec2 const& bounds, std::ofstream& where) {
+    std::vector<std::string> strings(bounds.y, std::string(bounds.x, '.'));
 
-        for (auto const& [pos, _] : robots) {
-            strings.at(pos.y).at(pos.x) = '*';
-        }
+    for (auto const& [pos, _] : robots) {
+        strings.at(pos.y).at(pos.x) = '*';
+    }
 
-        std::println(where, "\n\n\nAfter {} seconds:", secs);
-        for (auto const& s : strings) {
-            std::println(where, "{}", s);
-        }
-    };
+    std::println(where, "\n\n\nAfter {} seconds:", secs);
+    for (auto const& s : strings) {
+        std::println(where, "{}", s);
+    }
+};
 
-template <vec2 Bounds>
-auto const part2 = [](std::vector<robot> robots, std::ofstream& os) {
+auto const part2
+    = [](std::vector<robot> robots, vec2 const& bounds, std::ofstream& os) {
     for (auto counter : flux::ints(0, 10000)) {
-        print_robots<Bounds>(counter, robots, os);
+        print_robots(counter, robots, bounds, os);
 
         for (auto& [pos, vel] : robots) {
-            pos += vel + Bounds;
-            pos.x %= Bounds.x;
-            pos.y %= Bounds.y;
+            pos += vel + bounds;
+            pos.x %= bounds.x;
+            pos.y %= bounds.y;
         }
     }
 };
@@ -95,22 +116,63 @@ p=7,3 v=-1,2
 p=2,4 v=2,-3
 p=9,5 v=-3,-3)";
 
-static_assert(part1<{11, 7}>(parse_input(test_input)) == 12);
+static_assert(part1(parse_input(test_input), vec2{11, 7}) == 12);
+static_assert(part1(parse_input(test_input),
+                    std::integral_constant<vec2, vec2{11, 7}>{})
+              == 12);
 
 } // namespace
 
 int main(int argc, char** argv)
 {
+    // Usage: dec14 <input> [--width n] [--height n] [--cache]
+    // The input path must come first, as it is always read from argv[1]
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
     }
 
-    auto const robots = parse_input(aoc::string_from_file(argv[1]));
-    std::println("Part 1: {}", part1<{101, 103}>(robots));
+    vec2 const bounds{
+        aoc::get_option(argc, argv, "--width")
+            .transform(aoc::parse<int>)
+            .value_or(101),
+        aoc::get_option(argc, argv, "--height")
+            .transform(aoc::parse<int>)
+            .value_or(103)};
+    // Part 1 moves each robot 100 steps at once, which mustn't overflow
+    constexpr int max_side = 1'000'000;
+    if (bounds.x < 1 || bounds.y < 1 || bounds.x > max_side
+        || bounds.y > max_side) {
+        std::println(stderr, "Width and height must be between 1 and {}",
+                     max_side);
+        return -1;
+    }
+
+    auto const robots
+        = aoc::has_flag(argc, argv, "--cache")
+        ? aoc::parse_cached(argv[1], cache_version, parse_input, save_cache,
+                            load_cache)
+        : parse_input(aoc::string_from_file(argv[1]));
+
+    // The movement code relies on positions being inside the bounds, and on
+    // adding the bounds to a velocity making it non-negative
+    auto const fits = [&bounds](robot const& r) {
+        return r.pos.x >= 0 && r.pos.x < bounds.x && r.pos.y >= 0
+            && r.pos.y < bounds.y && std::abs(r.vel.x) < bounds.x
+            && std::abs(r.vel.y) < bounds.y;
+    };
+    if (!flux::all(robots, fits)) {
+        std::println(stderr, "Some robots don't fit a {}x{} room", bounds.x,
+                     bounds.y);
+        return -1;
+    }
+
+    std::println("Part 1: {}",
+                 aoc::dispatch<vec2{101, 103}, vec2{11, 7}>(
+                     bounds, [&](auto b) { return part1(robots, b); }));
 
     if constexpr (enable_part2) {
         std::ofstream out("output.txt");
-        part2<{101, 103}>(robots, out);
+        part2(robots, bounds, out);
     }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 
 #include <aoc.hpp>
+#include <limits>
 #include <queue>
 
 namespace {
@@ -14,29 +15,42 @@ constexpr direction south{0, 1};
 constexpr direction west{-1, 0};
 } // namespace dir
 
-struct grid2d : flux::inline_iter_base<grid2d> {
-    std::string data;
-    int width;
-    int height;
+// The cells are stored according to Layout (see aoc::layout), and iterating
+// over the grid visits them in row-major order whatever the layout
+template <typename Layout = aoc::layout::row_major>
+struct grid2d : flux::inline_iter_base<grid2d<Layout>> {
+    aoc::grid<char, Layout> cells;
 
     constexpr auto positions() const -> flux::random_access_sequence auto
     {
         return flux::cartesian_product_map(
-            [](int j, int i) { return position{i, j}; }, flux::ints(0, height),
-            flux::ints(0, width));
+            [](int j, int i) { return position{i, j}; },
+            flux::ints(0, cells.height), flux::ints(0, cells.width));
     }
 
     constexpr auto to_string() const -> std::string
     {
-        return flux::ref(data)
-            .chunk(width)
-            .flatten_with('\n')
-            .to<std::string>();
+        std::string str;
+        for (int y = 0; y < cells.height; ++y) {
+            if (y > 0) {
+                str += '\n';
+            }
+            for (int x = 0; x < cells.width; ++x) {
+                str += cells[{x, y}];
+            }
+        }
+        return str;
+    }
+
+    // Returns the offset of the cell at pos in the underlying storage
+    constexpr auto index(position const& pos) const -> std::size_t
+    {
+        return Layout::index(pos, cells.width, cells.height);
     }
 
     constexpr auto operator[](this auto& self, position const& pos) -> auto&
     {
-        return self.data.at(pos.y * self.width + pos.x);
+        return self.cells[pos];
     }
 
     struct flux_iter_traits : flux::default_iter_traits {
@@ -44,7 +58,7 @@ struct grid2d : flux::inline_iter_base<grid2d> {
 
         static constexpr auto last(grid2d const& self)
         {
-            return position{0, self.height};
+            return position{0, self.cells.height};
         }
 
         static constexpr auto is_last(grid2d const& self, position const& pos)
@@ -54,7 +68,7 @@ struct grid2d : flux::inline_iter_base<grid2d> {
 
         static constexpr auto inc(grid2d const& self, position& pos)
         {
-            if (++pos.x == self.width) {
+            if (++pos.x == self.cells.width) {
                 pos.x = 0;
                 ++pos.y;
             }
@@ -62,21 +76,19 @@ struct grid2d : flux::inline_iter_base<grid2d> {
 
         static constexpr auto read_at(auto& self, position const& pos) -> auto&
         {
-            return self.data.at(pos.y * self.width + pos.x);
+            return self.cells[pos];
         }
 
         static constexpr auto size(auto const& self)
         {
-            return flux::num::mul(self.width, self.height);
+            return flux::num::mul(self.cells.width, self.cells.height);
         }
     };
 };
 
-auto const parse_input = [](std::string_view input) -> grid2d {
-    return grid2d{
-        .data = flux::filter(input, flux::pred::neq('\n')).to<std::string>(),
-        .width = int(flux::find(input, '\n')),
-        .height = int(flux::count_eq(input, '\n'))};
+template <typename Layout = aoc::layout::row_major>
+auto const parse_input = [](std::string_view input) -> grid2d<Layout> {
+    return grid2d<Layout>{.cells = aoc::parse_grid<Layout>(input)};
 };
 
 template <typename G>
@@ -118,7 +130,7 @@ auto const dijkstra = []<Graph G>(G const& graph, G::node_type start) {
                 iter == costs.cend() || next_cost < iter->second) {
                 costs[next] = next_cost;
                 queue.push({next_cost, next});
-                paths[next].push_back(current);
+                paths[next] = {current};
             } else if (next_cost == iter->second) {
                 paths[next].push_back(current);
             }
@@ -128,10 +140,14 @@ auto const dijkstra = []<Graph G>(G const& graph, G::node_type start) {
     return std::pair(std::move(costs), std::move(paths));
 };
 
+// A node of the search is a cell and the direction we entered it in
+using search_node = std::pair<position, direction>;
+
+template <typename Grid>
 struct graph {
-    grid2d const& grid;
+    Grid const& grid;
 
-    using node_type = std::pair<position, direction>;
+    using node_type = search_node;
     using cost_type = int;
 
     constexpr auto get_neighbours(node_type const& node) const
@@ -155,36 +171,180 @@ struct graph {
     }
 };
 
-auto const part1 = [](grid2d const& grid) -> int {
-    return flux::filter(
-               dijkstra(graph{grid}, {flux::find(grid, 'S'), dir::east}).first,
-               [&](auto const& pair) { return grid[pair.first.first] == 'E'; })
-        .front()
-        ->second;
+// The end cell may be entered in more than one direction, so these find the
+// cheapest of the nodes which are on it
+template <typename Layout = aoc::layout::row_major>
+auto const part1 = [](grid2d<Layout> const& grid) -> int {
+    auto const costs
+        = dijkstra(graph{grid}, {flux::find(grid, 'S'), dir::east}).first;
+    return flux::ref(costs)
+        .filter([&](auto const& pair) { return grid[pair.first.first] == 'E'; })
+        .map([](auto const& pair) { return pair.second; })
+        .min()
+        .value();
 };
 
-auto const part2 = [](grid2d grid) -> int {
+template <typename Layout = aoc::layout::row_major>
+auto const part2 = [](grid2d<Layout> const& input) -> int {
+    auto grid = input;
     auto const start_pos = grid.find('S');
 
-    auto const paths = dijkstra(graph{grid}, {start_pos, dir::east}).second;
+    auto const [costs, paths] = dijkstra(graph{grid}, {start_pos, dir::east});
 
-    auto const end_node = flux::ref(paths)
-                              .filter([&](auto const& pair) {
-                                  return grid[pair.first.first] == 'E';
-                              })
-                              .front()
-                              ->first;
+    auto const end_nodes
+        = flux::ref(costs)
+              .filter([&](auto const& pair) {
+                  return grid[pair.first.first] == 'E';
+              })
+              .to<std::vector<std::pair<search_node, int>>>();
+    int const best = flux::ref(end_nodes)
+                         .map([](auto const& pair) { return pair.second; })
+                         .min()
+                         .value();
 
-    [&](this const auto& self, auto const& node) -> void {
+    auto const mark = [&](this const auto& self, auto const& node) -> void {
         grid[node.first] = 'O';
         if (node.first != start_pos) {
             flux::for_each(paths.at(node), self);
         }
-    }(end_node);
+    };
+    for (auto const& [node, cost] : end_nodes) {
+        if (cost == best) {
+            mark(node);
+        }
+    }
 
     return grid.count_eq('O');
 };
 
+// The same search, but with costs and predecessors kept in flat arrays indexed
+// by node id rather than in hash maps. A node's id is 4 * the storage offset of
+// its cell + the index of its direction in directions.
+constexpr std::array directions{dir::north, dir::east, dir::south, dir::west};
+
+constexpr int unreached = std::numeric_limits<int>::max();
+
+auto const node_id
+    = [](auto const& grid, position const& pos, int d) -> std::size_t {
+    return grid.index(pos) * 4 + d;
+};
+
+// Bit d of preds[id] is set if a cheapest route into node id comes from the
+// cell behind it, which it was facing directions[d] in
+struct dense_search {
+    std::vector<int> costs;
+    std::vector<std::uint8_t> preds;
+};
+
+auto const dijkstra_dense
+    = [](auto const& grid, position const& start) -> dense_search {
+    using entry = std::tuple<int, position, int>; // cost, cell, direction
+
+    std::size_t const n_nodes = grid.cells.data.size() * 4;
+    dense_search search{.costs = std::vector<int>(n_nodes, unreached),
+                        .preds = std::vector<std::uint8_t>(n_nodes)};
+    auto& [costs, preds] = search;
+
+    std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+    costs[node_id(grid, start, 1)] = 0;
+    queue.push({0, start, 1});
+
+    while (!queue.empty()) {
+        auto const [cost, pos, d] = queue.top();
+        queue.pop();
+
+        if (cost > costs[node_id(grid, pos, d)]) {
+            continue;
+        }
+        if (grid[pos] == 'E') {
+            break;
+        }
+
+        for (int next_d = 0; next_d < 4; ++next_d) {
+            position const next = pos + directions[next_d];
+            if (next_d == (d + 2) % 4 || grid[next] == '#') {
+                continue;
+            }
+
+            int const next_cost = cost + (next_d == d ? 1 : 1001);
+            std::size_t const next_id = node_id(grid, next, next_d);
+            if (next_cost < costs[next_id]) {
+                costs[next_id] = next_cost;
+                preds[next_id] = 1 << d;
+                queue.push({next_cost, next, next_d});
+            } else if (next_cost == costs[next_id]) {
+                preds[next_id] |= 1 << d;
+            }
+        }
+    }
+
+    return search;
+};
+
+// Returns the cheapest cost of the nodes on the end cell
+auto const best_end_cost
+    = [](auto const& grid, dense_search const& search) -> int {
+    position const end = flux::find(grid, 'E');
+    int best = unreached;
+    for (int d = 0; d < 4; ++d) {
+        best = std::min(best, search.costs[node_id(grid, end, d)]);
+    }
+    return best;
+};
+
+template <typename Layout = aoc::layout::row_major>
+auto const part1_dense = [](grid2d<Layout> const& grid) -> int {
+    return best_end_cost(grid, dijkstra_dense(grid, flux::find(grid, 'S')));
+};
+
+template <typename Layout = aoc::layout::row_major>
+auto const part2_dense = [](grid2d<Layout> const& grid) -> int {
+    auto const search = dijkstra_dense(grid, flux::find(grid, 'S'));
+    int const best = best_end_cost(grid, search);
+    position const end = flux::find(grid, 'E');
+
+    // Walk back over every cheapest route, visiting each node once
+    std::vector<bool> visited(search.costs.size());
+    std::vector<bool> on_route(grid.cells.data.size());
+    std::vector<std::pair<position, int>> stack;
+    for (int d = 0; d < 4; ++d) {
+        std::size_t const id = node_id(grid, end, d);
+        if (search.costs[id] == best) {
+            visited[id] = true;
+            stack.emplace_back(end, d);
+        }
+    }
+
+    while (!stack.empty()) {
+        auto const [pos, d] = stack.back();
+        stack.pop_back();
+        on_route[grid.index(pos)] = true;
+
+        position const prev = pos - directions[d];
+        auto const preds = search.preds[node_id(grid, pos, d)];
+        for (int prev_d = 0; prev_d < 4; ++prev_d) {
+            if ((preds & (1 << prev_d)) == 0) {
+                continue;
+            }
+            std::size_t const prev_id = node_id(grid, prev, prev_d);
+            if (!visited[prev_id]) {
+                visited[prev_id] = true;
+                stack.emplace_back(prev, prev_d);
+            }
+        }
+    }
+
+    return int(std::ranges::count(on_route, true));
+};
+
+using strategy_t = aoc::strategy<int, grid2d<> const&>;
+
+auto const part1_strategies = std::array{strategy_t{"hash-map", part1<>},
+                                         strategy_t{"dense", part1_dense<>}};
+
+auto const part2_strategies = std::array{strategy_t{"hash-map", part2<>},
+                                         strategy_t{"dense", part2_dense<>}};
+
 constexpr auto& test_input1 =
     R"(###############
 #.......#....E#
@@ -227,13 +387,25 @@ constexpr auto& test_input2 =
 int main(int argc, char** argv)
 {
     {
-        [[maybe_unused]] auto const test_grid1 = parse_input(test_input1);
-        assert(part1(test_grid1) == 7036);
-        assert(part2(test_grid1) == 45);
+        [[maybe_unused]] auto const test_grid1 = parse_input<>(test_input1);
+        [[maybe_unused]] auto const test_grid2 = parse_input<>(test_input2);
+        for (auto const& [_, func] : part1_strategies) {
+            assert(func(test_grid1) == 7036);
+            assert(func(test_grid2) == 11048);
+        }
+        for (auto const& [_, func] : part2_strategies) {
+            assert(func(test_grid1) == 45);
+            assert(func(test_grid2) == 64);
+        }
 
-        [[maybe_unused]] auto const test_grid2 = parse_input(test_input2);
-        assert(part1(test_grid2) == 11048);
-        assert(part2(test_grid2) == 64);
+        // The answers don't depend on how the grid is stored
+        using morton = aoc::layout::morton;
+        [[maybe_unused]] auto const morton_grid
+            = parse_input<morton>(test_input2);
+        assert(part1<morton>(morton_grid) == 11048);
+        assert(part2<morton>(morton_grid) == 64);
+        assert(part1_dense<morton>(morton_grid) == 11048);
+        assert(part2_dense<morton>(morton_grid) == 64);
     }
 
     if (argc < 2) {
@@ -241,7 +413,23 @@ int main(int argc, char** argv)
         return -1;
     }
 
-    auto const grid = parse_input(aoc::string_from_file(argv[1]));
-    std::println("Part 1: {}", part1(grid));
-    std::println("Part 2: {}", part2(grid));
+    auto const grid = parse_input<>(aoc::string_from_file(argv[1]));
+
+    if (aoc::has_flag(argc, argv, "--bench")) {
+        bool ok = aoc::compare_strategies("Part 1", part1_strategies, grid);
+        ok &= aoc::compare_strategies("Part 2", part2_strategies, grid);
+        return ok ? 0 : 1;
+    }
+
+    auto const name
+        = aoc::get_option(argc, argv, "--strategy").value_or("hash-map");
+    auto const p1 = aoc::find_strategy(part1_strategies, name);
+    auto const p2 = aoc::find_strategy(part2_strategies, name);
+    if (!p1 || !p2) {
+        std::println(stderr, "Unknown strategy {}", name);
+        return -1;
+    }
+
+    std::println("Part 1: {}", p1->func(grid));
+    std::println("Part 2: {}", p2->func(grid));
 }
\ No newline at end of file
@@ -60,21 +60,42 @@ auto const dijkstra = []<Graph G>(G const& graph, G::node_type start) {
     return costs;
 };
 
-template <int Size>
-struct grid_t {
-    std::bitset<Size * Size> data;
+// Grid size used to select the run-time sized fallback grid
+constexpr int dynamic_size = 0;
 
+template <int Size, typename Layout = aoc::layout::row_major>
+struct grid_t {
+    static constexpr int size = Size;
     static constexpr position target{Size - 1, Size - 1};
 
+    std::bitset<Layout::size(Size, Size)> data;
+
+    constexpr explicit grid_t(int) {}
+
     constexpr auto operator[](this auto& self, position const& pos)
     {
-        return self.data[pos.y * Size + pos.x];
+        return self.data[Layout::index(pos, Size, Size)];
     }
 };
 
-template <int Size>
+template <typename Layout>
+struct grid_t<dynamic_size, Layout> {
+    int size;
+    position target{size - 1, size - 1};
+
+    aoc::grid<bool, Layout> data{.width = size, .height = size};
+
+    constexpr explicit grid_t(int n) : size(n) {}
+
+    constexpr auto operator[](this auto& self, position const& pos)
+    {
+        return self.data[pos];
+    }
+};
+
+template <typename Grid>
 struct graph_t {
-    grid_t<Size> const& grid;
+    Grid const& grid;
 
     using node_type = position;
     using cost_type = int;
@@ -85,8 +106,8 @@ struct graph_t {
                               position{0, -1}, {1, 0}, {0, 1}, {-1, 0}})
             .map([&](position o) { return pos + o; })
             .filter([&](position n) {
-                return n.x >= 0 && n.x < Size && n.y >= 0 && n.y < Size
-                    && !grid[n];
+                return n.x >= 0 && n.x < grid.size && n.y >= 0
+                    && n.y < grid.size && !grid[n];
             });
     }
 
@@ -101,28 +122,106 @@ struct graph_t {
     }
 };
 
-template <int GridSize, std::size_t N>
-auto const part1 = [](std::span<position const> bytes) -> int {
-    grid_t<GridSize> grid{};
+// Returns the length of the shortest route after the first n_bytes have
+// fallen, or nullopt if they have already blocked every route
+template <int GridSize, typename Layout = aoc::layout::row_major>
+auto const part1 = [](std::span<position const> bytes, int grid_size,
+                      std::size_t n_bytes) -> std::optional<int> {
+    grid_t<GridSize, Layout> grid(grid_size);
 
-    flux::for_each(bytes.first<N>(),
+    flux::for_each(bytes.first(n_bytes),
                    [&](position const& pos) { grid[pos] = true; });
 
-    return dijkstra(graph_t{grid}, {0, 0}).at(grid.target);
+    auto const costs = dijkstra(graph_t{grid}, {0, 0});
+    if (auto iter = costs.find(grid.target); iter != costs.end()) {
+        return iter->second;
+    }
+    return std::nullopt;
+};
+
+// Returns the first byte after skip which blocks every route, or nullopt if
+// the route is never blocked
+template <int GridSize, typename Layout = aoc::layout::row_major>
+auto const part2 = [](std::span<position const> bytes, int grid_size,
+                      std::size_t skip) -> std::optional<position> {
+    auto const indices = std::views::iota(skip, bytes.size());
+    auto const iter = std::ranges::partition_point(indices, [&](std::size_t n) {
+        grid_t<GridSize, Layout> grid(grid_size);
+        flux::for_each(bytes.first(n + 1),
+                       [&](position const& pos) { grid[pos] = true; });
+        return dijkstra(graph_t{grid}, {0, 0}).contains(grid.target);
+    });
+    if (iter == indices.end()) {
+        return std::nullopt;
+    }
+    return bytes[*iter];
 };
 
-template <int GridSize, std::size_t Skip>
-auto const part2 = [](std::span<position const> bytes) -> position {
-    auto idx = *std::ranges::partition_point(
-        std::views::iota(Skip, bytes.size()), [&](std::size_t n) {
-            grid_t<GridSize> grid{};
-            flux::for_each(bytes.first(n + 1),
-                           [&](position const& pos) { grid[pos] = true; });
-            return dijkstra(graph_t{grid}, {0, 0}).contains(grid.target);
-        });
-    return bytes[idx];
+// Adds the bytes one at a time, but only searches for a new route when a byte
+// lands on the route we are currently using. Like part2, returns nullopt if
+// the route is never blocked.
+template <int GridSize, typename Layout = aoc::layout::row_major>
+auto const part2_incremental
+    = [](std::span<position const> bytes, int grid_size,
+         std::size_t skip) -> std::optional<position> {
+    grid_t<GridSize, Layout> grid(grid_size);
+    flux::for_each(bytes.first(skip),
+                   [&](position const& pos) { grid[pos] = true; });
+
+    // Returns the cells of a shortest route, or an empty set if there is none
+    auto find_route = [&]() -> aoc::hash_set<position> {
+        auto const graph = graph_t{grid};
+        auto const costs = dijkstra(graph, {0, 0});
+        auto const cost_of = [&](position const& p) {
+            return p == position{0, 0} ? 0 : costs.at(p);
+        };
+
+        aoc::hash_set<position> route;
+        if (!costs.contains(grid.target)) {
+            return route;
+        }
+
+        // Walk back from the target, stepping to any neighbour which is one
+        // move closer to the start
+        for (position pos = grid.target; pos != position{0, 0};) {
+            route.insert(pos);
+            pos = graph.get_neighbours(pos)
+                      .filter([&](position const& n) {
+                          return (n == position{0, 0} || costs.contains(n))
+                              && cost_of(n) == cost_of(pos) - 1;
+                      })
+                      .front()
+                      .value();
+        }
+        return route;
+    };
+
+    auto route = find_route();
+    for (std::size_t n = skip; n < bytes.size(); ++n) {
+        if (route.empty()) {
+            return bytes[n];
+        }
+
+        grid[bytes[n]] = true;
+        if (route.contains(bytes[n])) {
+            route = find_route();
+            if (route.empty()) {
+                return bytes[n];
+            }
+        }
+    }
+    return std::nullopt;
 };
 
+using part2_strategy
+    = aoc::strategy<std::optional<position>, std::span<position const>, int,
+                    std::size_t>;
+
+template <int GridSize>
+auto const part2_strategies
+    = std::array{part2_strategy{"binary-search", part2<GridSize>},
+                 part2_strategy{"incremental", part2_incremental<GridSize>}};
+
 constexpr auto& test_input = R"(5,4
 4,2
 4,5
@@ -156,16 +255,100 @@ int main(int argc, char** argv)
 {
     {
         [[maybe_unused]] auto const test_bytes = parse_input(test_input);
-        assert((part1<7, 12>(test_bytes) == 22));
-        assert((part2<7, 12>(test_bytes) == position{6, 1}));
+        assert((part1<7>(test_bytes, 7, 12) == 22));
+        assert((part2<7>(test_bytes, 7, 12) == position{6, 1}));
+        assert((part1<7, aoc::layout::morton>(test_bytes, 7, 12) == 22));
+        assert((part2<7, aoc::layout::tiled<4>>(test_bytes, 7, 12)
+                == position{6, 1}));
+        assert((part1<dynamic_size>(test_bytes, 7, 12) == 22));
+        assert((part2<dynamic_size>(test_bytes, 7, 12) == position{6, 1}));
+        for (auto const& [_, func] : part2_strategies<7>) {
+            assert((func(test_bytes, 7, 12) == position{6, 1}));
+        }
+        for (auto const& [_, func] : part2_strategies<dynamic_size>) {
+            assert((func(test_bytes, 7, 12) == position{6, 1}));
+        }
+
+        // The 21st byte blocks the example, so after 21 bytes there is no
+        // route for part 1
+        assert(!part1<7>(test_bytes, 7, 21));
+
+        // A byte in the middle of a 3x3 grid never blocks the route
+        std::array<position, 1> const centre{position{1, 1}};
+        assert((part1<dynamic_size>(centre, 3, 1) == 4));
+        for (auto const& [_, func] : part2_strategies<dynamic_size>) {
+            assert(!func(centre, 3, 0));
+            assert(!func(centre, 3, 1));
+        }
     }
 
+    // Usage: dec18 <input> [--size n] [--bytes n] [--strategy name] [--bench]
+    // The input path must come first, as it is always read from argv[1]
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
     }
 
+    int const grid_size = aoc::get_option(argc, argv, "--size")
+                              .transform(aoc::parse<int>)
+                              .value_or(71);
+    std::size_t const n_bytes = aoc::get_option(argc, argv, "--bytes")
+                                    .transform(aoc::parse<std::size_t>)
+                                    .value_or(1024);
+
     auto const bytes = parse_input(aoc::string_from_file(argv[1]));
-    std::println("Part 1: {}", part1<71, 1024>(bytes));
-    std::println("Part 2: {}", part2<71, 1024>(bytes));
-}
\ No newline at end of file
+
+    if (grid_size < 1) {
+        std::println(stderr, "Grid size must be positive");
+        return -1;
+    }
+    if (n_bytes > bytes.size()) {
+        std::println(stderr, "Asked for {} bytes, but the input only has {}",
+                     n_bytes, bytes.size());
+        return -1;
+    }
+    auto const in_grid = [grid_size](position p) {
+        return p.x >= 0 && p.x < grid_size && p.y >= 0 && p.y < grid_size;
+    };
+    if (!flux::all(bytes, in_grid)) {
+        std::println(stderr, "Some bytes fall outside a {0}x{0} grid",
+                     grid_size);
+        return -1;
+    }
+    auto const strategy
+        = aoc::get_option(argc, argv, "--strategy").value_or("binary-search");
+
+    // Use a grid specialised for the common sizes (the puzzle input and the
+    // example), or the run-time sized grid for any other size
+    return aoc::dispatch<71, 7>(grid_size, [&](auto size) -> int {
+        constexpr int N = aoc::constant_or<decltype(size), dynamic_size>;
+
+        auto const p1 = part1<N>(bytes, size, n_bytes);
+        if (!p1) {
+            std::println(stderr, "The first {} bytes already block the route",
+                         n_bytes);
+            return -1;
+        }
+        std::println("Part 1: {}", *p1);
+
+        if (aoc::has_flag(argc, argv, "--bench")) {
+            return aoc::compare_strategies("Part 2", part2_strategies<N>,
+                                           bytes, int(size), n_bytes)
+                ? 0
+                : 1;
+        }
+
+        auto const p2 = aoc::find_strategy(part2_strategies<N>, strategy);
+        if (!p2) {
+            std::println(stderr, "Unknown strategy {}", strategy);
+            return -1;
+        }
+        auto const blocker = p2->func(bytes, size, n_bytes);
+        if (!blocker) {
+            std::println(stderr, "No byte blocks the route");
+            return -1;
+        }
+        std::println("Part 2: {}", *blocker);
+        return 0;
+    });
+}
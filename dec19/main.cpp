@@ -19,6 +19,29 @@ auto const parse_input = [](std::string_view input)
     return std::pair(std::move(patterns), std::move(designs));
 };
 
+// Version of the layout of our pre-parsed input cache
+constexpr std::uint32_t cache_version = 1;
+
+using input_t = std::pair<std::vector<std::string>, std::vector<std::string>>;
+
+auto const save_cache = [](input_t const& input, aoc::cache::writer& out) {
+    out.add_strings(input.first);
+    out.add_strings(input.second);
+};
+
+auto const load_cache
+    = [](aoc::cache::reader const& in) -> std::optional<input_t> {
+    auto const patterns = in.strings(0);
+    auto const designs = in.strings(2);
+    if (!patterns || !designs) {
+        return std::nullopt;
+    }
+    auto const to_strings = [](std::vector<std::string_view> const& views) {
+        return std::vector<std::string>(views.begin(), views.end());
+    };
+    return input_t(to_strings(*patterns), to_strings(*designs));
+};
+
 auto part1 = [](std::span<std::string const> patterns,
                 std::span<std::string const> designs) -> i64 {
     auto test_design
@@ -38,7 +61,7 @@ auto part1 = [](std::span<std::string const> patterns,
 
 auto part2 = [](std::span<std::string const> patterns,
                 std::span<std::string const> designs) -> i64 {
-    aoc::hash_map<std::string_view, i64> memo;
+    aoc::memo<std::string_view, i64> memo;
 
     auto count_designs
         = [&](this auto const& self, std::string_view design) -> i64 {
@@ -46,8 +69,9 @@ auto part2 = [](std::span<std::string const> patterns,
             return 1;
         }
 
-        if (auto iter = memo.find(design); iter != memo.cend()) {
-            return iter->second;
+        auto const id = memo.intern(design);
+        if (auto const* cached = memo.find(id)) {
+            return *cached;
         }
 
         i64 count = flux::ref(patterns)
@@ -60,13 +84,60 @@ auto part2 = [](std::span<std::string const> patterns,
                         .map(self)
                         .sum();
 
-        memo[design] = count;
+        memo.insert(id, count);
         return count;
     };
 
     return flux::map(designs, count_designs).sum();
 };
 
+// Bottom-up alternative to the recursive solutions above: ways[i] holds the
+// number of ways of making the last i characters of the design
+auto const count_ways_dp = [](std::span<std::string const> patterns,
+                              std::string_view design) -> i64 {
+    std::vector<i64> ways(design.size() + 1);
+    ways[0] = 1;
+
+    for (std::size_t i = 1; i <= design.size(); ++i) {
+        auto const suffix = design.substr(design.size() - i);
+        ways[i] = flux::ref(patterns)
+                      .filter([&](std::string_view pattern) {
+                          return suffix.starts_with(pattern);
+                      })
+                      .map([&](std::string_view pattern) {
+                          return ways[i - pattern.size()];
+                      })
+                      .sum();
+    }
+
+    return ways.back();
+};
+
+auto part1_dp = [](std::span<std::string const> patterns,
+                   std::span<std::string const> designs) -> i64 {
+    return flux::count_if(designs, [&](std::string_view design) {
+        return count_ways_dp(patterns, design) > 0;
+    });
+};
+
+auto part2_dp = [](std::span<std::string const> patterns,
+                   std::span<std::string const> designs) -> i64 {
+    return flux::ref(designs)
+        .map([&](std::string_view design) {
+            return count_ways_dp(patterns, design);
+        })
+        .sum();
+};
+
+using strategy_t = aoc::strategy<i64, std::span<std::string const>,
+                                 std::span<std::string const>>;
+
+auto const part1_strategies
+    = std::array{strategy_t{"recursive", part1}, strategy_t{"dp", part1_dp}};
+
+auto const part2_strategies
+    = std::array{strategy_t{"recursive", part2}, strategy_t{"dp", part2_dp}};
+
 constexpr auto& test_input =
     R"(r, wr, b, g, bwu, rb, gb, br
 
@@ -87,8 +158,19 @@ int main(int argc, char** argv)
     {
         [[maybe_unused]] auto const [patterns, designs]
             = parse_input(test_input);
-        assert(part1(patterns, designs) == 6);
-        assert(part2(patterns, designs) == 16);
+        for (auto const& [_, func] : part1_strategies) {
+            assert(func(patterns, designs) == 6);
+        }
+        for (auto const& [_, func] : part2_strategies) {
+            assert(func(patterns, designs) == 16);
+        }
+    }
+
+    {
+        // An empty string can be the first key interned
+        aoc::memo<std::string_view, i64> memo;
+        memo.insert("", 1);
+        assert(memo.find("") != nullptr && *memo.find("") == 1);
     }
 
     if (argc < 2) {
@@ -97,7 +179,28 @@ int main(int argc, char** argv)
     }
 
     auto const [patterns, designs]
-        = parse_input(aoc::string_from_file(argv[1]));
-    std::println("Part 1: {}", part1(patterns, designs));
-    std::println("Part 2: {}", aoc::timed(part2, patterns, designs));
+        = aoc::has_flag(argc, argv, "--cache")
+        ? aoc::parse_cached(argv[1], cache_version, parse_input, save_cache,
+                            load_cache)
+        : parse_input(aoc::string_from_file(argv[1]));
+
+    if (aoc::has_flag(argc, argv, "--bench")) {
+        bool ok = aoc::compare_strategies("Part 1", part1_strategies, patterns,
+                                          designs);
+        ok &= aoc::compare_strategies("Part 2", part2_strategies, patterns,
+                                      designs);
+        return ok ? 0 : 1;
+    }
+
+    auto const name
+        = aoc::get_option(argc, argv, "--strategy").value_or("recursive");
+    auto const p1 = aoc::find_strategy(part1_strategies, name);
+    auto const p2 = aoc::find_strategy(part2_strategies, name);
+    if (!p1 || !p2) {
+        std::println(stderr, "Unknown strategy {}", name);
+        return -1;
+    }
+
+    std::println("Part 1: {}", p1->func(patterns, designs));
+    std::println("Part 2: {}", aoc::timed(p2->func, patterns, designs));
 }
\ No newline at end of file
@@ -13,52 +13,61 @@ constexpr direction south{0, 1};
 constexpr direction west{-1, 0};
 } // namespace dir
 
+// The cells are stored according to Layout (see aoc::layout)
+template <typename Layout = aoc::layout::row_major>
 struct grid2d {
-    std::string data;
-    int width;
-    int height;
+    aoc::grid<char, Layout> cells;
 
     constexpr auto is_in_bounds(position const& pos) const -> bool
     {
-        return pos.x >= 0 && pos.x < width && pos.y >= 0 && pos.y < height;
+        return cells.is_in_bounds(pos);
     }
 
     constexpr auto positions() const -> flux::random_access_sequence auto
     {
         return flux::cartesian_product_map(
-            [](int j, int i) { return position{i, j}; }, flux::ints(0, height),
-            flux::ints(0, width));
+            [](int j, int i) { return position{i, j}; },
+            flux::ints(0, cells.height), flux::ints(0, cells.width));
     }
 
     constexpr auto to_string() const -> std::string
     {
-        return flux::ref(data)
-            .chunk(width)
-            .flatten_with('\n')
-            .to<std::string>();
+        std::string str;
+        for (int y = 0; y < cells.height; ++y) {
+            if (y > 0) {
+                str += '\n';
+            }
+            for (int x = 0; x < cells.width; ++x) {
+                str += cells[{x, y}];
+            }
+        }
+        return str;
     }
 
     constexpr auto operator[](this auto& self, position const& pos) -> auto&
     {
-        return self.data.at(pos.y * self.width + pos.x);
+        return self.cells[pos];
     }
 };
 
-auto const parse_input = [](std::string_view input) -> grid2d {
-    return grid2d{.data = flux::filter(input, [](char c) { return c != '\n'; })
-                              .to<std::string>(),
-                  .width = int(flux::find(input, '\n')),
-                  .height = int(flux::count_eq(input, '\n'))};
+template <typename Layout = aoc::layout::row_major>
+auto const parse_input = [](std::string_view input) -> grid2d<Layout> {
+    return {aoc::parse_grid<Layout>(input)};
 };
 
 auto const manhattan_dist = [](position const& p1, position const& p2) {
     return std::abs(p1.x - p2.x) + std::abs(p1.y - p2.y);
 };
 
-auto const walk_path = [](grid2d grid) -> std::vector<position> {
+template <typename Layout>
+auto const walk_path = [](grid2d<Layout> grid) -> std::vector<position> {
     std::vector<position> path;
-    int start_idx = flux::find(grid.data, 'S');
-    auto start_pos = position{start_idx % grid.width, start_idx / grid.width};
+    auto const start_pos = grid.positions()
+                               .filter([&](position const& pos) {
+                                   return grid[pos] == 'S';
+                               })
+                               .front()
+                               .value();
 
     [&](this auto const& self, position pos) -> void {
         path.push_back(pos);
@@ -74,9 +83,9 @@ auto const walk_path = [](grid2d grid) -> std::vector<position> {
     return path;
 };
 
-template <int Dist>
-constexpr auto calculate = [](grid2d const& grid) {
-    auto const path = walk_path(grid);
+template <int Dist, typename Layout = aoc::layout::row_major>
+constexpr auto calculate = [](grid2d<Layout> const& grid) {
+    auto const path = walk_path<Layout>(grid);
 
     return flux::ints(0, path.size())
         .map([&](int i) {
@@ -115,12 +124,26 @@ constexpr auto part2 = calculate<20>;
 
 int main(int argc, char** argv)
 {
+    // The example's track is 85 cells long, and is found the same way however
+    // the grid is stored
+    {
+        [[maybe_unused]] auto const path
+            = walk_path<aoc::layout::row_major>(parse_input<>(test_input));
+        assert(path.size() == 85);
+        assert(walk_path<aoc::layout::tiled<4>>(
+                   parse_input<aoc::layout::tiled<4>>(test_input))
+               == path);
+        assert(walk_path<aoc::layout::morton>(
+                   parse_input<aoc::layout::morton>(test_input))
+               == path);
+    }
+
     if (argc < 2) {
         std::println(stderr, "No input");
         return -1;
     }
 
-    auto const grid = parse_input(aoc::string_from_file(argv[1]));
+    auto const grid = parse_input<>(aoc::string_from_file(argv[1]));
     std::println("Part 1: {}", part1(grid));
     std::println("Part 2: {}", part2(grid));
 }
\ No newline at end of file
@@ -68,16 +68,17 @@ constexpr std::string_view dirpad_moves_table[5][5] = {
 };
 
 template <int N>
-using cache_t = std::array<aoc::hash_map<std::string, i64>, N>;
+using cache_t = std::array<aoc::memo<std::string_view, i64>, N>;
 
-auto get_length_recursive(std::string str, int depth, auto& cache) -> i64
+auto get_length_recursive(std::string_view str, int depth, auto& cache) -> i64
 {
     if (depth == 0) {
         return str.size();
     }
 
-    if (auto iter = cache[depth].find(str); iter != cache[depth].end()) {
-        return iter->second;
+    auto const id = cache[depth].intern(str);
+    if (auto const* cached = cache[depth].find(id)) {
+        return *cached;
     }
 
     i64 len
@@ -86,12 +87,11 @@ auto get_length_recursive(std::string str, int depth, auto& cache) -> i64
                   return dirpad_moves_table[dirpad_idx(from)][dirpad_idx(to)];
               })
               .map([&](std::string_view next) {
-                  return get_length_recursive(std::string(next), depth - 1,
-                                              cache);
+                  return get_length_recursive(next, depth - 1, cache);
               })
               .sum();
 
-    cache[depth][std::move(str)] = len;
+    cache[depth].insert(id, len);
 
     return len;
 };
@@ -101,9 +101,6 @@ auto const calculate_complexity = [](std::string_view input) {
     i64 num = flux::filter(input, ::isdigit)._(aoc::parse<i64>);
 
     cache_t<Levels + 1> cache{};
-    for (auto& map : cache) {
-        map.reserve(16);
-    }
 
     auto len
         = flux::chain(flux::single('A'), input)
@@ -111,7 +108,7 @@ auto const calculate_complexity = [](std::string_view input) {
                   return numpad_moves_table[numpad_idx(from)][numpad_idx(to)];
               })
               .map([&](std::string_view str) {
-                  return get_length_recursive(std::string(str), Levels, cache);
+                  return get_length_recursive(str, Levels, cache);
               })
               .sum();
 